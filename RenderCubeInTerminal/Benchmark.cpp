@@ -0,0 +1,150 @@
+// benchmarks of math, which don't depend on windows.
+// built apart from RenderCubeInTerminal.exe. ex) g++ -std=c++20 -O2 -msse3 Benchmark.cpp Math.cpp -o benchmark
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "Math.h"
+#include "Primitive.h"
+
+using namespace std;
+
+// compare 128 bits and 64 bits path of DoubleFixedPoint multiplication, division
+void BenchmarkDoubleFixedPoint() {
+    const int valueNum = 1 << 16;
+    const int repeatNum = 256;
+
+    // raws in range of edge function inputs, so 64 bits path is valid for them
+    int64_t* lhsRaws = new int64_t[valueNum];
+    int64_t* rhsRaws = new int64_t[valueNum];
+    srand(0);
+    for (int i = 0; i < valueNum; i++) {
+        lhsRaws[i] = (static_cast<int64_t>(rand() & 0x7FFF) - 0x4000) << 12;
+        rhsRaws[i] = (static_cast<int64_t>(rand() & 0x7FFF) << 12) + 1;
+    }
+
+    auto measure = [&](const char* name, auto operation) {
+        int64_t sum = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int repeat = 0; repeat < repeatNum; repeat++) {
+            for (int i = 0; i < valueNum; i++) {
+                sum += operation(lhsRaws[i], rhsRaws[i]);
+            }
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(valueNum) * repeatNum);
+        cout << name << " : " << ns << " ns (" << sum << ")" << endl;
+    };
+
+    measure("mul 128 bits", [](int64_t lhs, int64_t rhs) { return DF::MulRawWide(lhs, rhs); });
+    measure("mul 64 bits", [](int64_t lhs, int64_t rhs) { return DF::MulRawNarrow(lhs, rhs); });
+    measure("mul operator", [](int64_t lhs, int64_t rhs) { DF l, r; l.raw = lhs; r.raw = rhs; return static_cast<int64_t>((l * r).raw); });
+    measure("div 128 bits", [](int64_t lhs, int64_t rhs) { return DF::DivRawWide(lhs, rhs); });
+    measure("div 64 bits", [](int64_t lhs, int64_t rhs) { return DF::DivRawNarrow(lhs, rhs); });
+    measure("div operator", [](int64_t lhs, int64_t rhs) { DF l, r; l.raw = lhs; r.raw = rhs; return static_cast<int64_t>((l / r).raw); });
+
+    delete[] lhsRaws;
+    delete[] rhsRaws;
+}
+
+// compare SIMD and scalar versions of Vec4, Mat4x4
+void BenchmarkMath() {
+    const int valueNum = 1 << 12;
+    const int repeatNum = 256;
+
+    srand(0);
+    auto randomFloat = []() { return static_cast<float>(rand()) / RAND_MAX * 2.0f - 1.0f; };
+    // diagonal is big, so matrices are invertible
+    Mat4x4* matrices = new Mat4x4[valueNum];
+    Vertex* vertices = new Vertex[valueNum];
+    Vertex* outVertices = new Vertex[valueNum];
+    for (int i = 0; i < valueNum; i++) {
+        for (int e = 0; e < 16; e++) {
+            matrices[i].e[e] = randomFloat() + (e % 5 == 0 ? 4.0f : 0.0f);
+        }
+        vertices[i].pos = Vec4(randomFloat(), randomFloat(), randomFloat(), randomFloat() + 2.0f);
+    }
+
+    auto measure = [&](const char* name, int operationNum, auto operation) {
+        float sum = 0.0f;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int repeat = 0; repeat < repeatNum; repeat++) {
+            sum += operation();
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(operationNum) * repeatNum);
+        cout << name << " : " << ns << " ns (" << sum << ")" << endl;
+    };
+
+    auto multiply = [&](auto mul) {
+        Mat4x4 result = Mat4x4::IDENTITY;
+        for (int i = 0; i < valueNum; i++) {
+            result = mul(matrices[i], matrices[(i + 1) % valueNum]);
+        }
+        return result.m00;
+    };
+    measure("mat * mat scalar", valueNum, [&]() { return multiply([](const Mat4x4& l, const Mat4x4& r) { return Mat4x4::MultiplyScalar(l, r); }); });
+    measure("mat * mat", valueNum, [&]() { return multiply([](const Mat4x4& l, const Mat4x4& r) { return l * r; }); });
+
+    auto transform = [&](auto mul) {
+        float sum = 0.0f;
+        for (int i = 0; i < valueNum; i++) {
+            sum += mul(matrices[i], vertices[i].pos).w;
+        }
+        return sum;
+    };
+    measure("mat * vec scalar", valueNum, [&]() { return transform([](const Mat4x4& m, const Vec4& v) { return Mat4x4::TransformScalar(m, v); }); });
+    measure("mat * vec", valueNum, [&]() { return transform([](const Mat4x4& m, const Vec4& v) { return m * v; }); });
+
+    measure("batch transform scalar", valueNum, [&]() {
+        Mat4x4::TransformScalar(matrices[0], &vertices[0].pos, sizeof(Vertex), &outVertices[0].pos, sizeof(Vertex), valueNum);
+        return outVertices[valueNum - 1].pos.w;
+    });
+    measure("batch transform", valueNum, [&]() {
+        Mat4x4::Transform(matrices[0], &vertices[0].pos, sizeof(Vertex), &outVertices[0].pos, sizeof(Vertex), valueNum);
+        return outVertices[valueNum - 1].pos.w;
+    });
+
+    auto invert = [&](auto inverse) {
+        float sum = 0.0f;
+        for (int i = 0; i < valueNum; i++) {
+            sum += inverse(matrices[i]).m33;
+        }
+        return sum;
+    };
+    measure("inverse scalar", valueNum, [&]() { return invert([](const Mat4x4& m) { return Mat4x4::InverseScalar(m); }); });
+    measure("inverse", valueNum, [&]() { return invert([](const Mat4x4& m) { return m.Inverse(); }); });
+    measure("transpose scalar", valueNum, [&]() { return invert([](const Mat4x4& m) { return Mat4x4::TransposeScalar(m); }); });
+    measure("transpose", valueNum, [&]() { return invert([](const Mat4x4& m) { return m.Transpose(); }); });
+
+    auto reciprocal = [&](auto rcp) {
+        float sum = 0.0f;
+        for (int i = 0; i < valueNum; i++) {
+            sum += rcp(vertices[i].pos).w;
+        }
+        return sum;
+    };
+    measure("reciprocal scalar", valueNum, [&]() { return reciprocal([](const Vec4& v) { return Vec4::ReciprocalScalar(v); }); });
+    measure("reciprocal", valueNum, [&]() { return reciprocal([](const Vec4& v) { return Vec4::Reciprocal(v); }); });
+
+    delete[] matrices;
+    delete[] vertices;
+    delete[] outVertices;
+}
+
+int main(int argc, char* argv[]) {
+    // benchmark is selected by name. all benchmarks run without it
+    bool isAll = argc <= 1;
+
+    if (isAll || strcmp(argv[1], "double-fixed-point") == 0) {
+        BenchmarkDoubleFixedPoint();
+    }
+
+    if (isAll || strcmp(argv[1], "math") == 0) {
+        BenchmarkMath();
+    }
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "HierarchicalZ.h"
+#include <cassert>
+
+HierarchicalZ::HierarchicalZ()
+{
+}
+
+HierarchicalZ::~HierarchicalZ()
+{
+	Terminate();
+}
+
+void HierarchicalZ::Setup(const ScissorRect& rect, const float* zBuffer, uint32_t pitch)
+{
+	assert(zBuffer != nullptr);
+
+	if (mMaxDepths != nullptr
+		&& zBuffer == mZBuffer
+		&& pitch == mPitch
+		&& rect.leftX == mRect.leftX
+		&& rect.topY == mRect.topY
+		&& rect.rightX == mRect.rightX
+		&& rect.bottomY == mRect.bottomY) {
+		return;
+	}
+
+	uint32_t cellXNum = (rect.rightX - rect.leftX + CELL_SIZE - 1) >> CELL_SIZE_LOG2;
+	uint32_t cellYNum = (rect.bottomY - rect.topY + CELL_SIZE - 1) >> CELL_SIZE_LOG2;
+	if (mMaxDepths == nullptr || cellXNum * cellYNum != mCellXNum * mCellYNum) {
+		Terminate();
+
+		mMaxDepths = new float[cellXNum * cellYNum];
+		mIsDirties = new bool[cellXNum * cellYNum];
+	}
+
+	mRect = rect;
+	mZBuffer = zBuffer;
+	mPitch = pitch;
+	mCellXNum = cellXNum;
+	mCellYNum = cellYNum;
+
+	Invalidate();
+}
+
+void HierarchicalZ::Terminate()
+{
+	if (mMaxDepths != nullptr) {
+		delete[] mMaxDepths;
+		mMaxDepths = nullptr;
+	}
+
+	if (mIsDirties != nullptr) {
+		delete[] mIsDirties;
+		mIsDirties = nullptr;
+	}
+
+	mCellXNum = 0;
+	mCellYNum = 0;
+}
+
+void HierarchicalZ::Invalidate()
+{
+	for (uint32_t i = 0; i < mCellXNum * mCellYNum; i++) {
+		mIsDirties[i] = true;
+	}
+}
+
+void HierarchicalZ::UpdateMaxDepth(uint32_t cellIndex)
+{
+	// cells on right, bottom side are cut by rect
+	int32_t leftX = (cellIndex % mCellXNum) << CELL_SIZE_LOG2;
+	int32_t topY = (cellIndex / mCellXNum) << CELL_SIZE_LOG2;
+	int32_t rightX = std::min(leftX + CELL_SIZE, mRect.rightX - mRect.leftX);
+	int32_t bottomY = std::min(topY + CELL_SIZE, mRect.bottomY - mRect.topY);
+
+	float maxDepth = mZBuffer[topY * mPitch + leftX];
+	for (int32_t y = topY; y < bottomY; y++) {
+		const float* row = mZBuffer + y * mPitch;
+		for (int32_t x = leftX; x < rightX; x++) {
+			maxDepth = std::max(maxDepth, row[x]);
+		}
+	}
+
+	mMaxDepths[cellIndex] = maxDepth;
+	mIsDirties[cellIndex] = false;
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+#include "Primitive.h"
+
+/// <summary>
+/// Coarse depth of z buffer. Keeps max depth of each 8*8 pixel cell,
+/// so rasterizer can reject triangles or blocks behind all pixels of cells before generating pixels.
+/// Max depth of a cell is recalculated from z buffer only when its farthest pixel has been overwritten.
+/// </summary>
+class HierarchicalZ {
+public:
+	static constexpr int32_t CELL_SIZE_LOG2 = 3;
+	static constexpr int32_t CELL_SIZE = 1 << CELL_SIZE_LOG2;
+
+private:
+	// interpolated depth of pixel can be a bit smaller than min depth of vertices by rounding error
+	static constexpr float DEPTH_EPSILON = 1e-5f;
+
+public:
+	HierarchicalZ();
+	~HierarchicalZ();
+
+	// zBuffer has pitch elements in a row and its first element is pixel (rect.leftX, rect.topY)
+	// max depths are kept when same z buffer is set up again
+	void Setup(const ScissorRect& rect, const float* zBuffer, uint32_t pitch);
+	void Terminate();
+
+	// z buffer is changed outside, so max depths are recalculated when they are needed
+	void Invalidate();
+
+	// pixel (x, y) which depth was oldDepth is written
+	inline void OnWrite(int32_t x, int32_t y, float oldDepth) {
+		uint32_t cellIndex = ((y - mRect.topY) >> CELL_SIZE_LOG2) * mCellXNum + ((x - mRect.leftX) >> CELL_SIZE_LOG2);
+		if (oldDepth >= mMaxDepths[cellIndex]) {
+			mIsDirties[cellIndex] = true;
+		}
+	}
+
+	// all pixels in [leftX, rightX] x [topY, bottomY] are nearer than minDepth,
+	// so no pixel which depth is minDepth or farther can pass depth test
+	inline bool IsOccluded(int32_t leftX, int32_t topY, int32_t rightX, int32_t bottomY, float minDepth) {
+		int32_t cellMinX = (std::max(leftX, mRect.leftX) - mRect.leftX) >> CELL_SIZE_LOG2;
+		int32_t cellMaxX = (std::min(rightX, mRect.rightX - 1) - mRect.leftX) >> CELL_SIZE_LOG2;
+		int32_t cellMinY = (std::max(topY, mRect.topY) - mRect.topY) >> CELL_SIZE_LOG2;
+		int32_t cellMaxY = (std::min(bottomY, mRect.bottomY - 1) - mRect.topY) >> CELL_SIZE_LOG2;
+		if (cellMinX > cellMaxX || cellMinY > cellMaxY) {
+			return false;
+		}
+
+		for (int32_t cellY = cellMinY; cellY <= cellMaxY; cellY++) {
+			for (int32_t cellX = cellMinX; cellX <= cellMaxX; cellX++) {
+				uint32_t cellIndex = cellY * mCellXNum + cellX;
+				if (mIsDirties[cellIndex]) {
+					UpdateMaxDepth(cellIndex);
+				}
+
+				if (minDepth <= mMaxDepths[cellIndex] * (1.0f + DEPTH_EPSILON)) {
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+private:
+	void UpdateMaxDepth(uint32_t cellIndex);
+
+private:
+	ScissorRect mRect = {};
+	const float* mZBuffer = nullptr;
+	uint32_t mPitch = 0;
+
+	uint32_t mCellXNum = 0;
+	uint32_t mCellYNum = 0;
+	float* mMaxDepths = nullptr;
+	bool* mIsDirties = nullptr;
+};
\ No newline at end of file
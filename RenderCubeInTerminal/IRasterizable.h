@@ -1,9 +1,36 @@
 #pragma once
 
-#include "List.hpp"
+#include "Primitive.h"
+#include "PixelOutput.h"
 
+// traversal algorithm of rasterizer
+enum class RasterizationType {
+	Normal = 0,
+	Partition, // 8*8 pixel blocks divided recursively
+	Advanced, // incremental edge stepping
+	Length
+};
+
+class TriangleSetupBase;
+
+// rasterizer of floating point engines, which sets up triangles of indices by itself
 class IRasterizable {
 public:
-	virtual void Rasterize(List* pixels, const List* vertices, const List* indices) = 0;
+	// only pixels which centers are in scissor are added.
+	// first varyingNum varyings of vertices are interpolated to pixels.
+	// materialIDs has material of each triangle of indices. pixels of all triangles have material 0 when it is null
+	virtual void Rasterize(PixelOutput* pixels, const List* vertices, const List* indices, const List* materialIDs, const ScissorRect& scissor,
+		uint32_t varyingNum) = 0;
 	virtual ~IRasterizable() {}
+};
+
+// rasterizer of fixed point engines, which reads triangles set up once per draw in format of engine (see RasterizerRegistry).
+//		setup is shared by rasterizers of all tiles and only read
+class ISetupRasterizable {
+public:
+	// same with IRasterizable, but material is in setup.
+	//		triangles : indices of triangles in setup. all triangles of setup when it is null
+	virtual void Rasterize(PixelOutput* pixels, const List* fixedVertices, const TriangleSetupBase& setup, const List* triangles, const ScissorRect& scissor,
+		uint32_t varyingNum) = 0;
+	virtual ~ISetupRasterizable() {}
 };
\ No newline at end of file
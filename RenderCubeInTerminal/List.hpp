@@ -81,6 +81,24 @@ public:
 		mSizeByte += mStride * copyLen;
 	}
 
+	// elements added by resizing are not initialized
+	void Resize(uint64_t newSize) {
+		uint64_t neededCapacityByte = mStride * newSize;
+		if (mCapacityByte < neededCapacityByte) {
+			uint64_t newCapacityByte = mCapacityByte;
+			for (; newCapacityByte < neededCapacityByte; newCapacityByte *= (1 + mExpandRatio));
+
+			uint8_t* newArr = new uint8_t[newCapacityByte];
+			memcpy(newArr, mArr, mSizeByte);
+
+			delete[] mArr;
+			mArr = newArr;
+			mCapacityByte = newCapacityByte;
+		}
+
+		mSizeByte = neededCapacityByte;
+	}
+
 	bool Remove(uint64_t index) {
 		if (index * mStride >= mSizeByte) {
 			return false;
@@ -116,6 +134,13 @@ public:
 		return reinterpret_cast<T*>(mArr)[index];
 	}
 
+	template<typename T>
+	inline T* GetData() const {
+		assert(sizeof(T) == mStride);
+
+		return reinterpret_cast<T*>(mArr);
+	}
+
 private:
 	uint64_t mCapacityByte = 0;
 	const float mExpandRatio = 0;
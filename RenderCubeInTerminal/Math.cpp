@@ -2,8 +2,205 @@
 
 const Vec3 Vec3::ZERO = Vec3(0, 0, 0);
 const Vec4 Vec4::ZERO = Vec4(0, 0, 0, 0);
+const Mat4x4 Mat4x4::IDENTITY = Mat4x4(Vec4(1, 0, 0, 0), Vec4(0, 1, 0, 0), Vec4(0, 0, 1, 0), Vec4(0, 0, 0, 1));
 
-const FixedVec4 FixedVec4::ZERO = FixedVec4(FP::ZERO, FP::ZERO, FP::ZERO, FP::ZERO);
+Mat4x4 Mat4x4::MultiplyScalar(const Mat4x4& lhs, const Mat4x4& rhs)
+{
+    Mat4x4 result;
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            result.m[r][c] = lhs.m[r][0] * rhs.m[0][c] + lhs.m[r][1] * rhs.m[1][c] + lhs.m[r][2] * rhs.m[2][c] + lhs.m[r][3] * rhs.m[3][c];
+        }
+    }
+    return result;
+}
+
+Vec4 Mat4x4::TransformScalar(const Mat4x4& matrix, const Vec4& v)
+{
+    return Vec4(
+        matrix.m00 * v.x + matrix.m01 * v.y + matrix.m02 * v.z + matrix.m03 * v.w,
+        matrix.m10 * v.x + matrix.m11 * v.y + matrix.m12 * v.z + matrix.m13 * v.w,
+        matrix.m20 * v.x + matrix.m21 * v.y + matrix.m22 * v.z + matrix.m23 * v.w,
+        matrix.m30 * v.x + matrix.m31 * v.y + matrix.m32 * v.z + matrix.m33 * v.w);
+}
+
+Mat4x4 Mat4x4::TransposeScalar(const Mat4x4& matrix)
+{
+    Mat4x4 result;
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            result.m[r][c] = matrix.m[c][r];
+        }
+    }
+    return result;
+}
+
+Mat4x4 Mat4x4::InverseScalar(const Mat4x4& matrix)
+{
+    const float* e = matrix.e;
+    Mat4x4 result;
+    float* inv = result.e;
+
+    // cofactor of e[i] is written to inv[transposed i], so inv is adjugate
+    inv[0] = e[5] * e[10] * e[15] - e[5] * e[11] * e[14] - e[9] * e[6] * e[15] + e[9] * e[7] * e[14] + e[13] * e[6] * e[11] - e[13] * e[7] * e[10];
+    inv[4] = -e[4] * e[10] * e[15] + e[4] * e[11] * e[14] + e[8] * e[6] * e[15] - e[8] * e[7] * e[14] - e[12] * e[6] * e[11] + e[12] * e[7] * e[10];
+    inv[8] = e[4] * e[9] * e[15] - e[4] * e[11] * e[13] - e[8] * e[5] * e[15] + e[8] * e[7] * e[13] + e[12] * e[5] * e[11] - e[12] * e[7] * e[9];
+    inv[12] = -e[4] * e[9] * e[14] + e[4] * e[10] * e[13] + e[8] * e[5] * e[14] - e[8] * e[6] * e[13] - e[12] * e[5] * e[10] + e[12] * e[6] * e[9];
+    inv[1] = -e[1] * e[10] * e[15] + e[1] * e[11] * e[14] + e[9] * e[2] * e[15] - e[9] * e[3] * e[14] - e[13] * e[2] * e[11] + e[13] * e[3] * e[10];
+    inv[5] = e[0] * e[10] * e[15] - e[0] * e[11] * e[14] - e[8] * e[2] * e[15] + e[8] * e[3] * e[14] + e[12] * e[2] * e[11] - e[12] * e[3] * e[10];
+    inv[9] = -e[0] * e[9] * e[15] + e[0] * e[11] * e[13] + e[8] * e[1] * e[15] - e[8] * e[3] * e[13] - e[12] * e[1] * e[11] + e[12] * e[3] * e[9];
+    inv[13] = e[0] * e[9] * e[14] - e[0] * e[10] * e[13] - e[8] * e[1] * e[14] + e[8] * e[2] * e[13] + e[12] * e[1] * e[10] - e[12] * e[2] * e[9];
+    inv[2] = e[1] * e[6] * e[15] - e[1] * e[7] * e[14] - e[5] * e[2] * e[15] + e[5] * e[3] * e[14] + e[13] * e[2] * e[7] - e[13] * e[3] * e[6];
+    inv[6] = -e[0] * e[6] * e[15] + e[0] * e[7] * e[14] + e[4] * e[2] * e[15] - e[4] * e[3] * e[14] - e[12] * e[2] * e[7] + e[12] * e[3] * e[6];
+    inv[10] = e[0] * e[5] * e[15] - e[0] * e[7] * e[13] - e[4] * e[1] * e[15] + e[4] * e[3] * e[13] + e[12] * e[1] * e[7] - e[12] * e[3] * e[5];
+    inv[14] = -e[0] * e[5] * e[14] + e[0] * e[6] * e[13] + e[4] * e[1] * e[14] - e[4] * e[2] * e[13] - e[12] * e[1] * e[6] + e[12] * e[2] * e[5];
+    inv[3] = -e[1] * e[6] * e[11] + e[1] * e[7] * e[10] + e[5] * e[2] * e[11] - e[5] * e[3] * e[10] - e[9] * e[2] * e[7] + e[9] * e[3] * e[6];
+    inv[7] = e[0] * e[6] * e[11] - e[0] * e[7] * e[10] - e[4] * e[2] * e[11] + e[4] * e[3] * e[10] + e[8] * e[2] * e[7] - e[8] * e[3] * e[6];
+    inv[11] = -e[0] * e[5] * e[11] + e[0] * e[7] * e[9] + e[4] * e[1] * e[11] - e[4] * e[3] * e[9] - e[8] * e[1] * e[7] + e[8] * e[3] * e[5];
+    inv[15] = e[0] * e[5] * e[10] - e[0] * e[6] * e[9] - e[4] * e[1] * e[10] + e[4] * e[2] * e[9] + e[8] * e[1] * e[6] - e[8] * e[2] * e[5];
+
+    float det = e[0] * inv[0] + e[1] * inv[4] + e[2] * inv[8] + e[3] * inv[12];
+    float invDet = 1.0f / det;
+    for (int i = 0; i < 16; i++) {
+        inv[i] *= invDet;
+    }
+
+    return result;
+}
+
+void Mat4x4::TransformScalar(const Mat4x4& matrix, const Vec4* in, uint32_t inStride, Vec4* out, uint32_t outStride, uint32_t num)
+{
+    const uint8_t* inBytes = reinterpret_cast<const uint8_t*>(in);
+    uint8_t* outBytes = reinterpret_cast<uint8_t*>(out);
+    for (uint32_t i = 0; i < num; i++) {
+        const Vec4& v = *reinterpret_cast<const Vec4*>(inBytes + static_cast<uint64_t>(i) * inStride);
+        *reinterpret_cast<Vec4*>(outBytes + static_cast<uint64_t>(i) * outStride) = TransformScalar(matrix, v);
+    }
+}
+
+#ifdef MATH_SIMD
+// 2x2 matrices (a b, c d) are in lanes (a, b, c, d)
+//      source : https://lxjk.github.io/2017/09/03/Fast-4x4-Matrix-Inverse-with-SSE-SIMD-Explained.html
+#define SHUFFLE_LANES(lhs, rhs, x, y, z, w) _mm_shuffle_ps(lhs, rhs, _MM_SHUFFLE(w, z, y, x))
+#define SWIZZLE_LANES(lanes, x, y, z, w) _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(lanes), _MM_SHUFFLE(w, z, y, x)))
+
+// A * B
+static inline __m128 Mul2x2(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, SWIZZLE_LANES(b, 0, 3, 0, 3)),
+        _mm_mul_ps(SWIZZLE_LANES(a, 1, 0, 3, 2), SWIZZLE_LANES(b, 2, 1, 2, 1)));
+}
+
+// adjugate(A) * B
+static inline __m128 AdjMul2x2(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(SWIZZLE_LANES(a, 3, 3, 0, 0), b),
+        _mm_mul_ps(SWIZZLE_LANES(a, 1, 1, 2, 2), SWIZZLE_LANES(b, 2, 3, 0, 1)));
+}
+
+// A * adjugate(B)
+static inline __m128 MulAdj2x2(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE_LANES(b, 3, 0, 3, 0)),
+        _mm_mul_ps(SWIZZLE_LANES(a, 1, 0, 3, 2), SWIZZLE_LANES(b, 2, 1, 2, 1)));
+}
+
+Mat4x4 Mat4x4::Inverse() const
+{
+    // M = | A B |
+    //     | C D |
+    __m128 a = _mm_movelh_ps(rows[0], rows[1]);
+    __m128 b = _mm_movehl_ps(rows[1], rows[0]);
+    __m128 c = _mm_movelh_ps(rows[2], rows[3]);
+    __m128 d = _mm_movehl_ps(rows[3], rows[2]);
+
+    // determinants (|A|, |B|, |C|, |D|)
+    __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(SHUFFLE_LANES(rows[0], rows[2], 0, 2, 0, 2), SHUFFLE_LANES(rows[1], rows[3], 1, 3, 1, 3)),
+        _mm_mul_ps(SHUFFLE_LANES(rows[0], rows[2], 1, 3, 1, 3), SHUFFLE_LANES(rows[1], rows[3], 0, 2, 0, 2)));
+    __m128 detA = SWIZZLE_LANES(detSub, 0, 0, 0, 0);
+    __m128 detB = SWIZZLE_LANES(detSub, 1, 1, 1, 1);
+    __m128 detC = SWIZZLE_LANES(detSub, 2, 2, 2, 2);
+    __m128 detD = SWIZZLE_LANES(detSub, 3, 3, 3, 3);
+
+    // inverse of M is 1 / |M| * | X Y |, and sub matrices are adjugates of
+    //                           | Z W |
+    //      X = |D|A - B(D#C), Y = |B|C - D(A#B)#, Z = |C|B - A(D#C)#, W = |A|D - C(A#B)
+    __m128 dAdjC = AdjMul2x2(d, c);
+    __m128 aAdjB = AdjMul2x2(a, b);
+    __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), Mul2x2(b, dAdjC));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), Mul2x2(c, aAdjB));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), MulAdj2x2(d, aAdjB));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), MulAdj2x2(a, dAdjC));
+
+    // |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+    __m128 trace = _mm_mul_ps(aAdjB, SWIZZLE_LANES(dAdjC, 0, 2, 1, 3));
+    trace = _mm_add_ps(trace, _mm_movehl_ps(trace, trace));
+    trace = _mm_add_ps(trace, SWIZZLE_LANES(trace, 1, 1, 1, 1));
+    trace = SWIZZLE_LANES(trace, 0, 0, 0, 0);
+    __m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+
+    // signs of adjugate
+    __m128 invDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+    x = _mm_mul_ps(x, invDetM);
+    y = _mm_mul_ps(y, invDetM);
+    z = _mm_mul_ps(z, invDetM);
+    w = _mm_mul_ps(w, invDetM);
+
+    // adjugate and store at once
+    Mat4x4 result;
+    result.rows[0] = SHUFFLE_LANES(x, y, 3, 1, 3, 1);
+    result.rows[1] = SHUFFLE_LANES(x, y, 2, 0, 2, 0);
+    result.rows[2] = SHUFFLE_LANES(z, w, 3, 1, 3, 1);
+    result.rows[3] = SHUFFLE_LANES(z, w, 2, 0, 2, 0);
+    return result;
+}
+
+#undef SHUFFLE_LANES
+#undef SWIZZLE_LANES
+
+void Mat4x4::Transform(const Mat4x4& matrix, const Vec4* in, uint32_t inStride, Vec4* out, uint32_t outStride, uint32_t num)
+{
+    const uint8_t* inBytes = reinterpret_cast<const uint8_t*>(in);
+    uint8_t* outBytes = reinterpret_cast<uint8_t*>(out);
+
+    // M * v is sum of column k * v[k], added in same order with scalar version
+    Mat4x4 columns = matrix.Transpose();
+
+    uint32_t i = 0;
+#ifdef __AVX__
+    // 2 vectors at once, a vector per 128 bits lane
+    const __m256 column0 = _mm256_broadcast_ps(&columns.rows[0]);
+    const __m256 column1 = _mm256_broadcast_ps(&columns.rows[1]);
+    const __m256 column2 = _mm256_broadcast_ps(&columns.rows[2]);
+    const __m256 column3 = _mm256_broadcast_ps(&columns.rows[3]);
+    for (; i + 2 <= num; i += 2) {
+        const float* v0 = reinterpret_cast<const float*>(inBytes + static_cast<uint64_t>(i) * inStride);
+        const float* v1 = reinterpret_cast<const float*>(inBytes + static_cast<uint64_t>(i + 1) * inStride);
+        __m256 v = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(v0)), _mm_loadu_ps(v1), 1);
+
+        __m256 result = _mm256_mul_ps(column0, _mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)));
+        result = _mm256_add_ps(result, _mm256_mul_ps(column1, _mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1))));
+        result = _mm256_add_ps(result, _mm256_mul_ps(column2, _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2))));
+        result = _mm256_add_ps(result, _mm256_mul_ps(column3, _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3))));
+
+        _mm_storeu_ps(reinterpret_cast<float*>(outBytes + static_cast<uint64_t>(i) * outStride), _mm256_castps256_ps128(result));
+        _mm_storeu_ps(reinterpret_cast<float*>(outBytes + static_cast<uint64_t>(i + 1) * outStride), _mm256_extractf128_ps(result, 1));
+    }
+#endif
+
+    for (; i < num; i++) {
+        __m128 v = _mm_loadu_ps(reinterpret_cast<const float*>(inBytes + static_cast<uint64_t>(i) * inStride));
+
+        __m128 result = _mm_mul_ps(columns.rows[0], _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+        result = _mm_add_ps(result, _mm_mul_ps(columns.rows[1], _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+        result = _mm_add_ps(result, _mm_mul_ps(columns.rows[2], _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+        result = _mm_add_ps(result, _mm_mul_ps(columns.rows[3], _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+
+        _mm_storeu_ps(reinterpret_cast<float*>(outBytes + static_cast<uint64_t>(i) * outStride), result);
+    }
+}
+#endif
 
 //const SNORM SNORM::MIN = SNORM(-1.0f);
 //const SNORM SNORM::MAX = SNORM(1.0f);
@@ -3,17 +3,43 @@
 #include "Constants.h"
 #include <iostream>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
 #include <immintrin.h>
+#ifdef _MSC_VER
 #include <intrin.h>
+#endif
 #include <cassert>
 
-#define min(a, b) (a > b ? b : a)
-#define max(a, b) (a > b ? a : b)
+// Vec4, Mat4x4 are computed in SSE registers when it is available.
+// batched transform uses AVX only when compiled with it (/arch:AVX), which project doesn't set, so it runs in SSE.
+// scalar versions are kept for other platforms, and to compare with them
+#if defined(_M_X64) || defined(__SSE3__)
+#define MATH_SIMD
+#endif
 
 class Math {
 public:
     static constexpr float Rad2Deg(float radian) { return radian * 180.0f / Constants::PI; }
     static constexpr float Deg2Rad(float degree) { return degree * Constants::PI / 180.0f; }            
+
+    // 1 / x in about 22 bits precision, by rcp estimate and a newton step
+    static inline float FastReciprocal(float x) {
+#ifdef MATH_SIMD
+        return _mm_cvtss_f32(ReciprocalLanes(_mm_set_ss(x)));
+#else
+        return 1.0f / x;
+#endif
+    }
+
+#ifdef MATH_SIMD
+    // r' = r * (2 - x * r)
+    static inline __m128 ReciprocalLanes(__m128 x) {
+        __m128 r = _mm_rcp_ps(x);
+        return _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(2.0f), _mm_mul_ps(x, r)));
+    }
+#endif
 };
 
 template<int INT, int FRAC>
@@ -110,36 +136,21 @@ struct FixedPoint {
         return raw != rhs.raw;
     }
 
+    // fraction bits are truncated when CONV_FRAC is smaller
     template<int CONV_INT, int CONV_FRAC>
-    FixedPoint<CONV_INT, CONV_FRAC> Convert() {        
-        int convFracMask = 1 << CONV_FRAC - 1;
-        int convIntMask = 1 << (CONV_INT + CONV_FRAC) - 1;
-        convIntMask &= ~convFracMask;
-        
-        int fracMask = 1 << FRAC_BITS_LEN - 1;
-        int intMask = 1 << BITS_LEN - 1;
-        intMask &= ~fracMask;
-
-        int fracPart = fracValue;
-        int intPart = intValue;
-
+    FixedPoint<CONV_INT, CONV_FRAC> Convert() const {
         FixedPoint<CONV_INT, CONV_FRAC> res;
-        res.raw = 0;
-        if (CONV_FRAC > FRAC_BITS_LEN) {
-            int leftShiftNum = CONV_FRAC - FRAC_BITS_LEN;
-            res.raw |= (fracPart << leftShiftNum) & convFracMask;
+        if constexpr (CONV_FRAC > FRAC_BITS_LEN) {
+            res.raw = raw * (1 << (CONV_FRAC - FRAC_BITS_LEN));
         }
         else {
-            int rightShiftNum = FRAC_BITS_LEN - CONV_FRAC;
-            res.raw |= (fracPart >> rightShiftNum) & convFracMask;
+            res.raw = raw >> (FRAC_BITS_LEN - CONV_FRAC);
         }
 
-        res.raw |= (intPart << CONV_INT) & convIntMask;
-
         return res;
     }
 
-    DoubleFixedPoint<INT*2, FRAC*2> ToDoubleFixedPoint();
+    DoubleFixedPoint<INT*2, FRAC*2> ToDoubleFixedPoint() const;
 
 
     float ToFloat() const {
@@ -163,12 +174,14 @@ struct DoubleFixedPoint {
     static constexpr uint8_t BITS_LEN = INT_BITS_LEN + FRAC_BITS_LEN;
     static const DoubleFixedPoint ZERO;
     static const DoubleFixedPoint ONE;
+    // raw of 32 bits or less is added, compared in 32 bits, and multiplied, divided in 64 bits always
+    typedef std::conditional_t<(INT + FRAC <= 32), int32_t, int64_t> Raw;
 
     union {
-        int64_t raw : INT_BITS_LEN + FRAC_BITS_LEN;
+        Raw raw : INT_BITS_LEN + FRAC_BITS_LEN;
         struct {
-            uint64_t fracValue : FRAC_BITS_LEN;
-            int64_t intValue : INT_BITS_LEN;
+            std::make_unsigned_t<Raw> fracValue : FRAC_BITS_LEN;
+            Raw intValue : INT_BITS_LEN;
         };
     };
 
@@ -212,19 +225,37 @@ struct DoubleFixedPoint {
         return res;
     }
 
-    inline DoubleFixedPoint operator*(const DoubleFixedPoint& rhs) const {
-        int64_t lowBits;
-        int64_t highBits;
-        lowBits = _mul128(raw, rhs.raw, &highBits);                
+    // raws which fit in 32 bits make product in 64 bits
+    static inline bool IsNarrowRaw(int64_t value) {
+        return value == static_cast<int32_t>(value);
+    }
 
-        DoubleFixedPoint res;
-        res.raw = __shiftright128(lowBits, highBits, FRAC_BITS_LEN);;
+    // raw which doesn't overflow when it is shifted left by FRAC_BITS_LEN
+    static inline bool IsNarrowDividendRaw(int64_t value) {
+        int64_t highBits = value >> (63 - FRAC_BITS_LEN);
+        return highBits == 0 || highBits == -1;
+    }
 
-        return res;
+    // (lhs * rhs) >> FRAC_BITS_LEN in 128 bits
+    static inline int64_t MulRawWide(int64_t lhs, int64_t rhs) {
+#ifdef _MSC_VER
+        int64_t highBits;
+        int64_t lowBits = _mul128(lhs, rhs, &highBits);
+        return __shiftright128(lowBits, highBits, FRAC_BITS_LEN);
+#else
+        return static_cast<int64_t>((static_cast<__int128>(lhs) * rhs) >> FRAC_BITS_LEN);
+#endif
     }
 
-    inline DoubleFixedPoint operator/(const DoubleFixedPoint& rhs) const {
-        int64_t lowBits = raw;
+    // (lhs * rhs) >> FRAC_BITS_LEN in 64 bits. lhs, rhs must be narrow raws
+    static inline int64_t MulRawNarrow(int64_t lhs, int64_t rhs) {
+        return (lhs * rhs) >> FRAC_BITS_LEN;
+    }
+
+    // (lhs << FRAC_BITS_LEN) / rhs in 128 bits
+    static inline int64_t DivRawWide(int64_t lhs, int64_t rhs) {
+#ifdef _MSC_VER
+        int64_t lowBits = lhs;
         int64_t highBits = 0;
         
         highBits = __shiftleft128(lowBits, highBits, FRAC_BITS_LEN);
@@ -235,10 +266,44 @@ struct DoubleFixedPoint {
         highBits = highBits >> (64 - FRAC_BITS_LEN);
         lowBits = lowBits << FRAC_BITS_LEN;
 
+        return _div128(highBits, lowBits, rhs, nullptr);
+#else
+        return static_cast<int64_t>((static_cast<__int128>(lhs) * (1LL << FRAC_BITS_LEN)) / rhs);
+#endif
+    }
+
+    // (lhs << FRAC_BITS_LEN) / rhs in 64 bits. lhs must be narrow dividend raw
+    static inline int64_t DivRawNarrow(int64_t lhs, int64_t rhs) {
+        return (lhs * (1LL << FRAC_BITS_LEN)) / rhs;
+    }
+
+    // raws of edge functions and barycentric coordinates mostly take 64 bits path
+    inline DoubleFixedPoint operator*(const DoubleFixedPoint& rhs) const {
+        DoubleFixedPoint res;
+        if constexpr (BITS_LEN <= 32) {
+            res.raw = MulRawNarrow(raw, rhs.raw);
+        }
+        else if (IsNarrowRaw(raw) && IsNarrowRaw(rhs.raw)) {
+            res.raw = MulRawNarrow(raw, rhs.raw);
+        }
+        else {
+            res.raw = MulRawWide(raw, rhs.raw);
+        }
 
+        return res;
+    }
 
+    inline DoubleFixedPoint operator/(const DoubleFixedPoint& rhs) const {
         DoubleFixedPoint res;
-        res.raw = _div128(highBits, lowBits, rhs.raw, nullptr);
+        if constexpr (BITS_LEN <= 32) {
+            res.raw = DivRawNarrow(raw, rhs.raw);
+        }
+        else if (IsNarrowDividendRaw(raw)) {
+            res.raw = DivRawNarrow(raw, rhs.raw);
+        }
+        else {
+            res.raw = DivRawWide(raw, rhs.raw);
+        }
 
         return res;
     }
@@ -313,7 +378,7 @@ FixedPoint<INT/2, FRAC/2> DoubleFixedPoint<INT, FRAC>::ToFixedPoint() const {
     uint64_t fracPart = static_cast<uint64_t>(fracValue);
     int64_t intPart = static_cast<int64_t>(intValue);
 
-    FixedPoint res;
+    FP res;
     res.raw = 0;
     if (FRAC_BITS_LEN < FP::FRAC_BITS_LEN) {
         int leftShiftNum = FP::FRAC_BITS_LEN - FRAC_BITS_LEN;
@@ -330,7 +395,7 @@ FixedPoint<INT/2, FRAC/2> DoubleFixedPoint<INT, FRAC>::ToFixedPoint() const {
 }
 
 template<int INT, int FRAC>
-DoubleFixedPoint<INT*2, FRAC*2> FixedPoint<INT, FRAC>::ToDoubleFixedPoint() {
+DoubleFixedPoint<INT*2, FRAC*2> FixedPoint<INT, FRAC>::ToDoubleFixedPoint() const {
     typedef DoubleFixedPoint<INT * 2, FRAC * 2> DF;
 
     uint64_t convFracMask = (1ULL << DF::FRAC_BITS_LEN) - 1;
@@ -517,6 +582,30 @@ struct Vec4 {
         this->w = w;
     }
 
+#ifdef MATH_SIMD
+    // Vec4 is packed in arrays of vertices, pixels, so it is loaded unaligned
+    inline __m128 Load() const {
+        return _mm_loadu_ps(&x);
+    }
+
+    static inline Vec4 Store(__m128 lanes) {
+        Vec4 result(0.0f, 0.0f, 0.0f, 0.0f);
+        _mm_storeu_ps(&result.x, lanes);
+        return result;
+    }
+
+    Vec4 operator+(const Vec4& rhs) const {
+        return Store(_mm_add_ps(Load(), rhs.Load()));
+    }
+
+    Vec4 operator-(const Vec4& rhs) const {
+        return Store(_mm_sub_ps(Load(), rhs.Load()));
+    }
+
+    Vec4 operator*(const float value) const {
+        return Store(_mm_mul_ps(Load(), _mm_set1_ps(value)));
+    }
+#else
     Vec4 operator+(const Vec4& rhs) const {
         return Vec4(x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w);
     }
@@ -528,6 +617,7 @@ struct Vec4 {
     Vec4 operator*(const float value) const {
         return Vec4(x * value, y * value, z * value, w * value);
     }
+#endif
 
     friend std::ostream& operator<<(std::ostream& lhs, const Vec4& rhs) {
         lhs << "(" << rhs.x << "," << rhs.y << "," << rhs.z  << "," << rhs.w << ")";
@@ -536,51 +626,95 @@ struct Vec4 {
     }
 
     // static
-    static inline float Dot(const Vec4& v1, const Vec4& v2) { return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w; }
+    static inline float DotScalar(const Vec4& v1, const Vec4& v2) { return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w; }
+    static inline Vec4 ReciprocalScalar(const Vec4& v) { return Vec4(1.0f / v.x, 1.0f / v.y, 1.0f / v.z, 1.0f / v.w); }
+#ifdef MATH_SIMD
+    // products are added in same order with scalar version
+    static inline float Dot(const Vec4& v1, const Vec4& v2) {
+        __m128 products = _mm_mul_ps(v1.Load(), v2.Load());
+        __m128 sum = _mm_add_ss(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(1, 1, 1, 1)));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 2, 2, 2)));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(products, products, _MM_SHUFFLE(3, 3, 3, 3)));
+        return _mm_cvtss_f32(sum);
+    }
+    // 1 / elements, see Math::FastReciprocal
+    static inline Vec4 Reciprocal(const Vec4& v) { return Store(Math::ReciprocalLanes(v.Load())); }
+#else
+    static inline float Dot(const Vec4& v1, const Vec4& v2) { return DotScalar(v1, v2); }
+    static inline Vec4 Reciprocal(const Vec4& v) { return ReciprocalScalar(v); }
+#endif
     static inline Vec4 Lerp(const Vec4& v1, const Vec4& v2, float t) { return v1 * (1.0f - t) + v2 * (t); }
     
     static const Vec4 ZERO;
 };
 
-struct FixedVec4 {
-    FP x;
-    FP y;
-    FP z;
-    FP w;
+template<typename FIXED_POINT>
+struct BasicFixedVec4 {
+    FIXED_POINT x;
+    FIXED_POINT y;
+    FIXED_POINT z;
+    FIXED_POINT w;
 
-    inline FixedVec4(FP x, FP y, FP z, FP w) : x(x), y(y), z(z), w(w) {
+    inline BasicFixedVec4(FIXED_POINT x, FIXED_POINT y, FIXED_POINT z, FIXED_POINT w) : x(x), y(y), z(z), w(w) {
     }
 
-    inline FixedVec4 operator+(const FixedVec4& rhs) const {
-        return FixedVec4(x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w);
+    inline BasicFixedVec4 operator+(const BasicFixedVec4& rhs) const {
+        return BasicFixedVec4(x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w);
     }
 
-    inline FixedVec4 operator-(const FixedVec4& rhs) const {
-        return FixedVec4(x - rhs.x, y - rhs.y, z - rhs.z, w - rhs.w);
+    inline BasicFixedVec4 operator-(const BasicFixedVec4& rhs) const {
+        return BasicFixedVec4(x - rhs.x, y - rhs.y, z - rhs.z, w - rhs.w);
     }
 
-    inline FixedVec4 operator*(const FP& value) const {
-        return FixedVec4(x * value, y * value, z * value, w * value);
+    inline BasicFixedVec4 operator*(const FIXED_POINT& value) const {
+        return BasicFixedVec4(x * value, y * value, z * value, w * value);
     }
 
     inline Vec4 ToVec4() const {
         return Vec4(x.ToFloat(), y.ToFloat(), z.ToFloat(), w.ToFloat());
     }
 
-    friend std::ostream& operator<<(std::ostream& lhs, const FixedVec4& rhs) {
+    friend std::ostream& operator<<(std::ostream& lhs, const BasicFixedVec4& rhs) {
         lhs << "(" << rhs.x.ToFloat() << "," << rhs.y.ToFloat() << "," << rhs.z.ToFloat() << "," << rhs.w.ToFloat() << ")";
         return lhs;
 
     }
 
     // static
-    static inline FP Dot(const FixedVec4& v1, const FixedVec4& v2) { return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w; }
-    static inline FixedVec4 Lerp(const FixedVec4& v1, const FixedVec4& v2, FP t) { return v1 * (FP::ONE - t) + v2 * (t); }    
+    static inline FIXED_POINT Dot(const BasicFixedVec4& v1, const BasicFixedVec4& v2) { return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w; }
+    static inline BasicFixedVec4 Lerp(const BasicFixedVec4& v1, const BasicFixedVec4& v2, FIXED_POINT t) { return v1 * (FIXED_POINT::ONE - t) + v2 * (t); }    
+
+    static const BasicFixedVec4 ZERO;
+};
 
-    static const FixedVec4 ZERO;
+template<typename FIXED_POINT>
+const BasicFixedVec4<FIXED_POINT> BasicFixedVec4<FIXED_POINT>::ZERO = BasicFixedVec4<FIXED_POINT>(FIXED_POINT::ZERO, FIXED_POINT::ZERO, FIXED_POINT::ZERO, FIXED_POINT::ZERO);
+
+typedef BasicFixedVec4<FP> FixedVec4;
+
+/// <summary>
+/// Number format of fixed point rasterizer.
+/// x, y of vertices are FIXED_POINT, so its fraction bits are sub pixel bits,
+/// and edge function values are DoubleFixedPoint of it.
+/// </summary>
+template<typename FIXED_POINT>
+struct FixedPointFormat {
+    typedef FIXED_POINT FP;
+    typedef DoubleFixedPoint<FP::INT_BITS_LEN * 2, FP::FRAC_BITS_LEN * 2> DF;
+    typedef BasicFixedVec4<FP> FixedVec4;
+
+    // range of x, y in viewport space where difference of positions and edge function values don't overflow
+    static constexpr float GUARD_BAND_MIN = -static_cast<float>(1 << (FP::INT_BITS_LEN - 2));
+    static constexpr float GUARD_BAND_MAX = static_cast<float>((1 << (FP::INT_BITS_LEN - 2)) - 1);
 };
 
-struct Mat4x4 {
+// 8 bits sub pixel, 48 bits edge function value
+typedef FixedPointFormat<FP> WideFixedPointFormat;
+// 4 bits sub pixel, 30 bits edge function value which is stepped in 32 bits. guard band is [-512, 511]
+typedef FixedPointFormat<FixedPoint<11, 4>> NarrowFixedPointFormat;
+
+// row major. vector is column vector, so M * v transforms v
+struct alignas(16) Mat4x4 {
     union {
         float e[16];
         float m[4][4];
@@ -590,22 +724,81 @@ struct Mat4x4 {
             float m20; float m21; float m22; float m23;
             float m30; float m31; float m32; float m33;
         };
-        struct {
-            Vec4 row0;
-            Vec4 row1;
-            Vec4 row2;
-            Vec4 row3;
-        };
+#ifdef MATH_SIMD
+        __m128 rows[4];
+#endif
     };
 
     Mat4x4(float e[16]) {
         memcpy(this->e, e, sizeof(float) * 16);
     }
 
-    Mat4x4(Vec4 r0, Vec4 r1, Vec4 r2, Vec4 r3) {
-        row0 = r0;
-        row1 = r1;
-        row2 = r2;
-        row3 = r3;
+    Mat4x4() : e{} {
     }
+
+    Mat4x4(Vec4 r0, Vec4 r1, Vec4 r2, Vec4 r3) {
+        SetRow(0, r0);
+        SetRow(1, r1);
+        SetRow(2, r2);
+        SetRow(3, r3);
+    }
+
+    inline Vec4 GetRow(int r) const { return Vec4(m[r][0], m[r][1], m[r][2], m[r][3]); }
+    inline void SetRow(int r, const Vec4& row) { memcpy(m[r], &row.x, sizeof(float) * 4); }
+
+#ifdef MATH_SIMD
+    // row r of result is sum of lhs.m[r][k] * row k of rhs, added in same order with scalar version
+    Mat4x4 operator*(const Mat4x4& rhs) const {
+        Mat4x4 result;
+        for (int r = 0; r < 4; r++) {
+            __m128 row = _mm_mul_ps(_mm_set1_ps(m[r][0]), rhs.rows[0]);
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[r][1]), rhs.rows[1]));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[r][2]), rhs.rows[2]));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[r][3]), rhs.rows[3]));
+            result.rows[r] = row;
+        }
+        return result;
+    }
+
+    Vec4 operator*(const Vec4& v) const {
+        __m128 products0 = _mm_mul_ps(rows[0], v.Load());
+        __m128 products1 = _mm_mul_ps(rows[1], v.Load());
+        __m128 products2 = _mm_mul_ps(rows[2], v.Load());
+        __m128 products3 = _mm_mul_ps(rows[3], v.Load());
+        // lane r of column k is product k of row r
+        _MM_TRANSPOSE4_PS(products0, products1, products2, products3);
+        return Vec4::Store(_mm_add_ps(_mm_add_ps(_mm_add_ps(products0, products1), products2), products3));
+    }
+
+    Mat4x4 Transpose() const {
+        Mat4x4 result = *this;
+        _MM_TRANSPOSE4_PS(result.rows[0], result.rows[1], result.rows[2], result.rows[3]);
+        return result;
+    }
+
+    // block wise inverse of 2x2 sub matrices. result is undefined when determinant is 0
+    Mat4x4 Inverse() const;
+
+    // out[i] = M * in[i]. in, out are strides bytes apart, so they can be positions in vertices.
+    // 2 vectors per iteration with AVX, otherwise 1
+    static void Transform(const Mat4x4& matrix, const Vec4* in, uint32_t inStride, Vec4* out, uint32_t outStride, uint32_t num);
+#else
+    Mat4x4 operator*(const Mat4x4& rhs) const { return MultiplyScalar(*this, rhs); }
+    Vec4 operator*(const Vec4& v) const { return TransformScalar(*this, v); }
+    Mat4x4 Transpose() const { return TransposeScalar(*this); }
+    Mat4x4 Inverse() const { return InverseScalar(*this); }
+    static void Transform(const Mat4x4& matrix, const Vec4* in, uint32_t inStride, Vec4* out, uint32_t outStride, uint32_t num) {
+        TransformScalar(matrix, in, inStride, out, outStride, num);
+    }
+#endif
+
+    // scalar versions
+    static Mat4x4 MultiplyScalar(const Mat4x4& lhs, const Mat4x4& rhs);
+    static Vec4 TransformScalar(const Mat4x4& matrix, const Vec4& v);
+    static Mat4x4 TransposeScalar(const Mat4x4& matrix);
+    // cofactors divided by determinant. result is undefined when determinant is 0
+    static Mat4x4 InverseScalar(const Mat4x4& matrix);
+    static void TransformScalar(const Mat4x4& matrix, const Vec4* in, uint32_t inStride, Vec4* out, uint32_t outStride, uint32_t num);
+
+    static const Mat4x4 IDENTITY;
 };
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "PixelOutput.h"
+#include "PixelShader.h"
+#include <cassert>
+
+PixelOutput::PixelOutput(List* pixels, List* spans) : mPixels(pixels), mSpans(spans)
+{
+	assert(pixels != nullptr);
+}
+
+PixelOutput::PixelOutput(PixelShader* pixelShader, wchar_t* renderBuffer, float* zBuffer, uint32_t pitch, int32_t originX, int32_t originY,
+	HierarchicalZ* hierarchicalZ)
+	: mPixelShader(pixelShader),
+	mRenderBuffer(renderBuffer),
+	mZBuffer(zBuffer),
+	mPitch(pitch),
+	mOriginX(originX),
+	mOriginY(originY),
+	mHierarchicalZ(hierarchicalZ)
+{
+	assert(pixelShader != nullptr && renderBuffer != nullptr && zBuffer != nullptr);
+}
+
+void PixelOutput::ShadePixel(const Pixel& pixel)
+{
+	PixelShaderManager::OutPixel outPixel = mPixelShader->ExecuteOnePixel(pixel);
+	MergePixel(outPixel.x, outPixel.y, outPixel.depth, outPixel.c);
+}
+
+void PixelOutput::ShadeSpan(const Span& span)
+{
+	PixelShaderManager::OutPixel outPixels[SHADE_SPAN_LENGTH];
+	for (uint32_t start = 0; start < span.length; start += SHADE_SPAN_LENGTH) {
+		uint32_t length = std::min(span.length - start, SHADE_SPAN_LENGTH);
+		mPixelShader->ExecuteSpan(span.GetSubSpan(start, length), outPixels);
+
+		for (uint32_t i = 0; i < length; i++) {
+			MergePixel(outPixels[i].x, outPixels[i].y, outPixels[i].depth, outPixels[i].c);
+		}
+	}
+}
+
+inline void PixelOutput::MergePixel(float pixelX, float pixelY, float depth, wchar_t c)
+{
+	// rasterizer adds only pixels in scissor, so pixel is always in buffers
+	int32_t x = static_cast<int32_t>(pixelX) - mOriginX;
+	int32_t y = static_cast<int32_t>(pixelY) - mOriginY;
+	uint32_t index = y * mPitch + x;
+
+	// depth testing
+	if (depth >= mZBuffer[index]) {
+		return;
+	}
+
+	if (mHierarchicalZ != nullptr) {
+		mHierarchicalZ->OnWrite(static_cast<int32_t>(pixelX), static_cast<int32_t>(pixelY), mZBuffer[index]);
+	}
+
+	mZBuffer[index] = depth;
+	mRenderBuffer[index] = c;
+}
\ No newline at end of file
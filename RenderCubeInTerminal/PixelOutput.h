@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+#include "List.hpp"
+#include "Primitive.h"
+#include "HierarchicalZ.h"
+
+class PixelShader;
+
+/// <summary>
+/// Destination of pixels which rasterizer generates.
+/// Pixels are added to pixel list, or shaded and depth tested directly into render, z buffer (fused),
+/// so they never reach intermediate pixel lists.
+/// </summary>
+class PixelOutput {
+public:
+	// pixels are added to list.
+	// spans are added to span list, or to pixel list pixel by pixel when span list is null
+	explicit PixelOutput(List* pixels, List* spans = nullptr);
+	// pixels are shaded and depth tested.
+	// buffers have pitch elements in a row and their first element is pixel (originX, originY)
+	// hierarchicalZ is optional and has to be set up over same z buffer
+	PixelOutput(PixelShader* pixelShader, wchar_t* renderBuffer, float* zBuffer, uint32_t pitch, int32_t originX, int32_t originY,
+		HierarchicalZ* hierarchicalZ = nullptr);
+
+	inline void Add(const Pixel& pixel) {
+		if (mPixels != nullptr) {
+			mPixels->Add(pixel);
+			return;
+		}
+
+		ShadePixel(pixel);
+	}
+
+	// pixels of span have no varyings
+	inline void AddSpan(const Span& span) {
+		if (mSpans != nullptr) {
+			mSpans->Add(span);
+			return;
+		}
+
+		if (mPixels != nullptr) {
+			for (uint32_t i = 0; i < span.length; i++) {
+				mPixels->Add(span.GetPixel(i));
+			}
+			return;
+		}
+
+		ShadeSpan(span);
+	}
+
+	// every pixel in [leftX, rightX] x [topY, bottomY] whose depth is minDepth or farther fails depth test
+	inline bool IsOccluded(int32_t leftX, int32_t topY, int32_t rightX, int32_t bottomY, float minDepth) {
+		if (mHierarchicalZ == nullptr) {
+			return false;
+		}
+
+		return mHierarchicalZ->IsOccluded(leftX, topY, rightX, bottomY, minDepth);
+	}
+
+private:
+	// pixel shader shades span by runs of this length at most
+	static constexpr uint32_t SHADE_SPAN_LENGTH = 64;
+
+private:
+	void ShadePixel(const Pixel& pixel);
+	void ShadeSpan(const Span& span);
+	// depth test and write shaded pixel
+	inline void MergePixel(float x, float y, float depth, wchar_t c);
+
+private:
+	List* mPixels = nullptr;
+	List* mSpans = nullptr;
+
+	// fused
+	PixelShader* mPixelShader = nullptr;
+	wchar_t* mRenderBuffer = nullptr;
+	float* mZBuffer = nullptr;
+	uint32_t mPitch = 0;
+	int32_t mOriginX = 0;
+	int32_t mOriginY = 0;
+	HierarchicalZ* mHierarchicalZ = nullptr;
+};
\ No newline at end of file
@@ -5,4 +5,12 @@
 class PixelShader {
 public:
 	virtual inline PixelShaderManager::OutPixel ExecuteOnePixel(const Pixel& pixel) = 0;
+
+	// outPixels has span.length elements.
+	// shader which doesn't need every pixel restored can override it to shade whole run at once
+	virtual inline void ExecuteSpan(const Span& span, PixelShaderManager::OutPixel* outPixels) {
+		for (uint32_t i = 0; i < span.length; i++) {
+			outPixels[i] = ExecuteOnePixel(span.GetPixel(i));
+		}
+	}
 };
\ No newline at end of file
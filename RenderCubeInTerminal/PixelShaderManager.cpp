@@ -56,5 +56,13 @@ void PixelShaderManager::Execute(SWRasterizer* rasterizer)
 		mOutputPixels[i] = mPixelShader->ExecuteOnePixel(inputPixel);
 	}
 
+	// spans are shaded by whole runs after pixels
+	uint64_t spanLength = rasterizer->GetSpanLength();
+	for (int i = 0; i < spanLength; i++) {
+		const Span& inputSpan = rasterizer->GetSpan(i);
+		mPixelShader->ExecuteSpan(inputSpan, &mOutputPixels[pixelLength]);
+		pixelLength += inputSpan.length;
+	}
+
 	mOutPixelLen = pixelLength;
 }
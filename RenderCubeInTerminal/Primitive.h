@@ -1,17 +1,23 @@
 #pragma once
 #include "Math.h"
 
+// max number of float varyings (uv, normal, color, intensity ...) of a vertex.
+// number of varyings used in a draw is given to rasterizer, so unused varyings cost nothing
+static constexpr uint32_t MAX_VARYING_NUM = 8;
+
 struct Vertex {
 	Vec4 pos;
+	float varyings[MAX_VARYING_NUM];
 
-	Vertex() : pos(Vec4::ZERO) {
+	Vertex() : pos(Vec4::ZERO), varyings{} {
 	}
 
-	Vertex(Vec4 pos) : pos(pos) {}
+	Vertex(Vec4 pos) : pos(pos), varyings{} {}
 };
 
 struct FixedVertex {
 	FixedVec4 pos;
+	float varyings[MAX_VARYING_NUM];
 
 	FixedVertex() : pos(FixedVec4::ZERO) {
 
@@ -27,22 +33,71 @@ struct FixedVertex {
 
 };
 
-struct Triangle {
-	union {
-		Vertex vertices[3];
-		struct {
-			Vertex v1;
-			Vertex v2;
-			Vertex v3;
-		};
-	};
-
-	Triangle(Vertex v1, Vertex v2, Vertex v3) : v1(v1), v2(v2), v3(v3) {}
+// read only view of num elements in caller's memory. element i is stride * i bytes after data,
+// so elements can be fields of bigger interleaved structs
+template<typename T>
+struct ArrayView {
+	const T* data;
+	uint32_t num;
+	uint32_t stride;
+
+	ArrayView() : data(nullptr), num(0), stride(sizeof(T)) {}
+	ArrayView(const T* data, uint32_t num, uint32_t stride = sizeof(T)) : data(data), num(num), stride(stride) {}
+
+	inline const T& operator[](uint32_t i) const {
+		return *reinterpret_cast<const T*>(reinterpret_cast<const uint8_t*>(data) + static_cast<uint64_t>(i) * stride);
+	}
 };
 
 struct Pixel {
 	Vec4 pos;
+	// perspective correct. not initialized
+	float varyings[MAX_VARYING_NUM];
+	// material of triangle which pixel is from
+	uint32_t materialID;
+
+	Pixel() : pos(Vec4::ZERO), materialID(0) {}
+	Pixel(Vec4 pos) : pos(pos), materialID(0) {}
+};
+
+// run of covered pixels [leftX, leftX + length) in row y of a triangle without varyings.
+// 1 / w is linear along row, so pixels are restored from its plane instead of being stored
+struct Span {
+	int32_t y;
+	int32_t leftX;
+	uint32_t length;
+	// 1 / w at center of left pixel, and its difference by 1 x
+	float invW;
+	float invWDx;
+	uint32_t materialID;
+
+	inline Pixel GetPixel(uint32_t i) const {
+		Pixel pixel;
+		pixel.pos.x = static_cast<float>(leftX + static_cast<int32_t>(i)) + 0.5f;
+		pixel.pos.y = static_cast<float>(y) + 0.5f;
+		pixel.pos.w = invW + invWDx * static_cast<float>(i);
+		pixel.pos.z = 1.0f / pixel.pos.w;
+		pixel.materialID = materialID;
+
+		return pixel;
+	}
+
+	// pixels [start, start + subLength) of span
+	inline Span GetSubSpan(uint32_t start, uint32_t subLength) const {
+		Span sub = *this;
+		sub.leftX += static_cast<int32_t>(start);
+		sub.length = subLength;
+		sub.invW += invWDx * static_cast<float>(start);
+
+		return sub;
+	}
+};
 
-	Pixel() : pos(Vec4::ZERO) {}
-	Pixel(Vec4 pos) : pos(pos) {}
+// pixel rectangle rasterizers are allowed to write.
+// [leftX, rightX) x [topY, bottomY) in viewport pixel coordinates
+struct ScissorRect {
+	int32_t leftX;
+	int32_t topY;
+	int32_t rightX;
+	int32_t bottomY;
 };
\ No newline at end of file
@@ -1,8 +1,6 @@
 #include "PseudoRenderer.h"
 #include "Constants.h"
 
-#undef max;
-
 
 void PseudoRenderer::Initialize() {
     // console
@@ -219,7 +217,7 @@ void PseudoRenderer::WriteLinesInConsoleBuffer(wchar_t* consoleBuffer, const wch
     size_t remainCharLen = Constants::CONSOLE_MAX_TEXT_LEN - mTextLineIndex * Constants::CONSOLE_SCREEN_WIDTH;
     while (remainCharLen > 0) {
         size_t lineCharLen = wcslen(line);
-        memcpy(consoleBuffer + mTextLineIndex * Constants::CONSOLE_SCREEN_WIDTH, line, min(lineCharLen, remainCharLen) * sizeof(wchar_t));
+        memcpy(consoleBuffer + mTextLineIndex * Constants::CONSOLE_SCREEN_WIDTH, line, std::min(lineCharLen, remainCharLen) * sizeof(wchar_t));
         remainCharLen -= Constants::CONSOLE_SCREEN_WIDTH;
 
         mTextLineIndex += lineCharLen / Constants::CONSOLE_SCREEN_WIDTH + 1;
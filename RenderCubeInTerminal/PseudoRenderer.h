@@ -28,11 +28,9 @@
 
 #ifdef _WIN32
 #include <Windows.h>
-#undef max
 #undef near
 #undef far
 #endif
-#define min(x, y) (x > y ? y : x)
 
 #include "Constants.h"
 #include "Math.h"
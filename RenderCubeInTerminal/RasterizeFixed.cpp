@@ -1,477 +1,575 @@
 #include "RasterizeFixed.h"
+#include <cassert>
+#include <immintrin.h>
+
+// lanes of micro triangle kernel, a triangle per lane. AVX2 tests 8 triangles, SSE tests 4 triangles at once
+#ifdef __AVX2__
+typedef __m256i Lanes;
+static constexpr uint32_t LANE_NUM = 8;
+
+static inline Lanes SetLanes(int32_t value) { return _mm256_set1_epi32(value); }
+static inline Lanes LoadLanes(const int32_t* src) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(src)); }
+static inline Lanes AddLanes(Lanes lhs, Lanes rhs) { return _mm256_add_epi32(lhs, rhs); }
+static inline Lanes AndLanes(Lanes lhs, Lanes rhs) { return _mm256_and_si256(lhs, rhs); }
+static inline Lanes CmpLessLanes(Lanes lhs, Lanes rhs) { return _mm256_cmpgt_epi32(rhs, lhs); }
+static inline uint32_t MaskLanes(Lanes lanes) { return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(lanes))); }
+#else
+typedef __m128i Lanes;
+static constexpr uint32_t LANE_NUM = 4;
+
+static inline Lanes SetLanes(int32_t value) { return _mm_set1_epi32(value); }
+static inline Lanes LoadLanes(const int32_t* src) { return _mm_load_si128(reinterpret_cast<const __m128i*>(src)); }
+static inline Lanes AddLanes(Lanes lhs, Lanes rhs) { return _mm_add_epi32(lhs, rhs); }
+static inline Lanes AndLanes(Lanes lhs, Lanes rhs) { return _mm_and_si128(lhs, rhs); }
+static inline Lanes CmpLessLanes(Lanes lhs, Lanes rhs) { return _mm_cmplt_epi32(lhs, rhs); }
+static inline uint32_t MaskLanes(Lanes lanes) { return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(lanes))); }
+#endif
 
-// todo : save is left, top line each triangle
-// todo : left, top  ̸ ؼ  
-void RasterizeFixed::Rasterize(List* pixels, const List* fixedVertices, const List* indices)
+static inline uint32_t LowestBitIndex(uint64_t mask)
 {
-	const static FP halfOne = FP(0.5f);
-	const static FP one = FP(1.0f);
-	const static FP four = FP(4.0f);
-	const static FP eight = FP(8.0f);
-	for (uint32_t indexIdx = 0; indexIdx < indices->GetSize(); indexIdx += 3) {
-		const FixedVertex& v0 = fixedVertices->At<FixedVertex>(indices->At<uint32_t>(indexIdx));
-		const FixedVertex& v1 = fixedVertices->At<FixedVertex>(indices->At<uint32_t>(indexIdx + 1));
-		const FixedVertex& v2 = fixedVertices->At<FixedVertex>(indices->At<uint32_t>(indexIdx + 2));
-
-		// calculate bbox of pixel covers triangle
-		mMinX = min(v0.pos.x, min(v1.pos.x, v2.pos.x));
-		mMaxX = max(v0.pos.x, max(v1.pos.x, v2.pos.x));
-		mMinY = min(v0.pos.y, min(v1.pos.y, v2.pos.y));
-		mMaxY = max(v0.pos.y, max(v1.pos.y, v2.pos.y));
-
-		// conversion of common number from floating number to fixed number
-		FP minXFloor = mMinX.Floor();
-		FP minYFloor = mMinY.Floor();
-		FP startX = mMinX - minXFloor > halfOne ? minXFloor + one + halfOne : minXFloor + halfOne;
-		FP startY = mMinY - minYFloor > halfOne ? minYFloor + one + halfOne : minYFloor + halfOne;
-		FixedVec4 startPos(startX, startY, 0, 0);
-
-		// pre calculate 2 * triangle size
-		mTriSizeMul2 = EdgeFunction(v0.pos, v1.pos, v2.pos);
-		//		because of precision of fixed point, 
-		//		difference positions of vertices before conversion of fixed point can be same after it.
-		if (mTriSizeMul2 == 0) {
-			continue;
-		}
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return index;
+#else
+	return __builtin_ctzll(mask);
+#endif
+}
 
-		// fixed number & partition rasterization
-#if RASTERIZATION_TYPE == PARTITION_RASTERIZATION
-		// pre calculate difference of edge value by 2^i x, 2^i y				
-		mDxEdge01s[0] = (v1.pos.y - v0.pos.y).ToDoubleFixedPoint();
-		mDxEdge12s[0] = (v2.pos.y - v1.pos.y).ToDoubleFixedPoint();
-		mDxEdge20s[0] = (v0.pos.y - v2.pos.y).ToDoubleFixedPoint();
-		mDyEdge01s[0] = (v0.pos.x - v1.pos.x).ToDoubleFixedPoint();
-		mDyEdge12s[0] = (v1.pos.x - v2.pos.x).ToDoubleFixedPoint();
-		mDyEdge20s[0] = (v2.pos.x - v0.pos.x).ToDoubleFixedPoint();
-
-		DF startEdge01 = EdgeFunction(startPos, v0.pos, v1.pos);
-		DF startEdge12 = EdgeFunction(startPos, v1.pos, v2.pos);
-		DF startEdge20 = EdgeFunction(startPos, v2.pos, v0.pos);
-
-#pragma UNROLL(3)
-		for (int i = 1; i <= 3; i++) {
-			mDxEdge01s[i] = mDxEdge01s[0] * (1 << i); // (2^i)			
-			mDxEdge12s[i] = mDxEdge12s[0] * (1 << i);
-			mDxEdge20s[i] = mDxEdge20s[0] * (1 << i);
-
-
-			mDyEdge01s[i] = mDyEdge01s[0] * (1 << i);
-			mDyEdge12s[i] = mDyEdge12s[0] * (1 << i);
-			mDyEdge20s[i] = mDyEdge20s[0] * (1 << i);
-		}
+template<RasterizationType TYPE, typename FORMAT>
+RasterizeFixed<TYPE, FORMAT>::RasterizeFixed()
+{
+	for (uint8_t i = 0; i <= BLOCK_SIZE_LOG2; i++) {
+		mBlockSteps[i] = FP(static_cast<float>(1 << i));
+	}
 
-		// rasterize bunch of pixels starts with 8*8 pixels
-		DF yEdge01 = startEdge01;
-		DF yEdge12 = startEdge12;
-		DF yEdge20 = startEdge20;
-		for (FP y = startY; y <= mMaxY; y += eight) {
+	for (uint8_t i = 0; i < MAX_MASK_BLOCK_SIZE; i++) {
+		mBlockOffsets[i] = FP(static_cast<float>(i));
+	}
 
-			DF xEdge01 = yEdge01;
-			DF xEdge12 = yEdge12;
-			DF xEdge20 = yEdge20;
-			for (FP x = startX; x <= mMaxX; x += eight) {
-				RasterizePart(pixels, v0.pos, v1.pos, v2.pos, x, y, 3, xEdge01, xEdge12, xEdge20);
+	mMicroTriangles = new List(sizeof(uint32_t), RESERVED_MICRO_TRIANGLE_NUM);
+}
 
-				xEdge01 += mDxEdge01s[3];
-				xEdge12 += mDxEdge12s[3];
-				xEdge20 += mDxEdge20s[3];
-			}
+template<RasterizationType TYPE, typename FORMAT>
+RasterizeFixed<TYPE, FORMAT>::~RasterizeFixed()
+{
+	delete mMicroTriangles;
+}
 
-			yEdge01 += mDyEdge01s[3];
-			yEdge12 += mDyEdge12s[3];
-			yEdge20 += mDyEdge20s[3];
+template<RasterizationType TYPE, typename FORMAT>
+void RasterizeFixed<TYPE, FORMAT>::Rasterize(PixelOutput* pixels, const List* fixedVertices, const TriangleSetupBase& triangleSetup, const List* triangles,
+	const ScissorRect& scissor, uint32_t varyingNum)
+{
+	// setup is made in format of this rasterizer (see RasterizerRegistry::CreateTriangleSetup)
+	assert(dynamic_cast<const TriangleSetup<FORMAT>*>(&triangleSetup) != nullptr);
+	const TriangleSetup<FORMAT>& setup = static_cast<const TriangleSetup<FORMAT>&>(triangleSetup);
+
+	mMicroTriangles->Reset(sizeof(uint32_t));
+	uint32_t triangleNum = triangles != nullptr ? static_cast<uint32_t>(triangles->GetSize()) : setup.GetTriangleNum();
+	for (uint32_t i = 0; i < triangleNum; i++) {
+		uint32_t triangle = triangles != nullptr ? triangles->At<uint32_t>(i) : i;
+		if (IsMicroTriangle(setup, triangle, scissor)) {
+			// hidden by pixels drawn already. pixels of gathered triangles can only hide more
+			int32_t minX, minY, maxX, maxY;
+			setup.GetBBoxInScissor(triangle, scissor, &minX, &minY, &maxX, &maxY);
+			float minDepth = std::min(setup.GetVertexW(0, triangle), std::min(setup.GetVertexW(1, triangle), setup.GetVertexW(2, triangle)));
+			if (pixels->IsOccluded(minX, minY, maxX, maxY, minDepth)) {
+				continue;
+			}
 
+			mMicroTriangles->Add<uint32_t>(triangle);
+			if (mMicroTriangles->GetSize() == LANE_NUM) {
+				RasterizeMicroTriangles(pixels, fixedVertices, setup, scissor, varyingNum);
+			}
+			continue;
 		}
-#elif RASTERIZATION_TYPE == ADVANCED_RASTERIZATION
-		mDxEdge01s[0] = (v1.pos.y - v0.pos.y).ToDoubleFixedPoint();
-		mDxEdge12s[0] = (v2.pos.y - v1.pos.y).ToDoubleFixedPoint();
-		mDxEdge20s[0] = (v0.pos.y - v2.pos.y).ToDoubleFixedPoint();
-		mDyEdge01s[0] = (v0.pos.x - v1.pos.x).ToDoubleFixedPoint();
-		mDyEdge12s[0] = (v1.pos.x - v2.pos.x).ToDoubleFixedPoint();
-		mDyEdge20s[0] = (v2.pos.x - v0.pos.x).ToDoubleFixedPoint();
-
-		DF yEdge01 = EdgeFunctionFixedPoint(startPos, v0.pos, v1.pos);
-		DF yEdge12 = EdgeFunctionFixedPoint(startPos, v1.pos, v2.pos);
-		DF yEdge20 = EdgeFunctionFixedPoint(startPos, v2.pos, v0.pos);
-		for (FP y = startY;
-			y <= mMaxY;
-			y += one,
-			yEdge01 += mDyEdge01s[0],
-			yEdge12 += mDyEdge12s[0],
-			yEdge20 += mDyEdge20s[0])
-		{
-			DF xEdge01 = yEdge01;
-			DF xEdge12 = yEdge12;
-			DF xEdge20 = yEdge20;
 
-			for (FP x = startX;
-				x <= mMaxX;
-				x += one,
-				xEdge01 += mDxEdge01s[0],
-				xEdge12 += mDxEdge12s[0],
-				xEdge20 += mDxEdge20s[0])
-			{
-				FixedVec4 pixelPos(x, y, FP::ZERO, FP::ZERO);
-				DF edge01 = EdgeFunctionFixedPoint(pixelPos, v0.pos, v1.pos);
-				DF edge12 = EdgeFunctionFixedPoint(pixelPos, v1.pos, v2.pos);
-				DF edge20 = EdgeFunctionFixedPoint(pixelPos, v2.pos, v0.pos);
-
-				//TODO :  if ȭ
-				if (edge01 > DF::ZERO
-					|| edge12 > DF::ZERO
-					|| edge20 > DF::ZERO) {
-					continue;
-				}
+		// triangles are drawn in order, so gathered micro triangles go first
+		RasterizeMicroTriangles(pixels, fixedVertices, setup, scissor, varyingNum);
+		RasterizeTriangle(pixels, fixedVertices, setup, triangle, scissor, varyingNum);
+	}
 
-				if (edge01 == DF::ZERO
-					&& !IsLeftLineFixedPoint(v0.pos, v1.pos)
-					&& !IsTopLineFixedPoint(v0.pos, v1.pos)) {
-					continue;
-				}
+	RasterizeMicroTriangles(pixels, fixedVertices, setup, scissor, varyingNum);
+}
 
-				if (edge12 == DF::ZERO
-					&& !IsLeftLineFixedPoint(v1.pos, v2.pos)
-					&& !IsTopLineFixedPoint(v1.pos, v2.pos)) {
-					continue;
-				}
+template<RasterizationType TYPE, typename FORMAT>
+void RasterizeFixed<TYPE, FORMAT>::LoadTriangle(const List* fixedVertices, const TriangleSetup<FORMAT>& setup, uint32_t triangle, uint32_t varyingNum)
+{
+	mInvTriSizeMul2 = setup.GetInvTriSizeMul2(triangle);
+	mVertexWs[0] = setup.GetVertexW(0, triangle);
+	mVertexWs[1] = setup.GetVertexW(1, triangle);
+	mVertexWs[2] = setup.GetVertexW(2, triangle);
+	mMaterialID = setup.GetMaterialID(triangle);
+
+	// barycentric coordinate of vertex is edge value of opposite edge * mInvTriSizeMul2
+	const float* oppositeWs[EDGE_NUM] = { &mVertexWs[2], &mVertexWs[0], &mVertexWs[1] };
+	mInvWDx = 0.0;
+	for (uint8_t e = 0; e < EDGE_NUM; e++) {
+		mInvWEdges[e] = mInvTriSizeMul2 / *oppositeWs[e];
+		mInvWDx += setup.GetEdgeX(e, triangle).ToDouble() * mInvWEdges[e];
+	}
 
-				if (edge20 == DF::ZERO
-					&& !IsLeftLineFixedPoint(v2.pos, v0.pos)
-					&& !IsTopLineFixedPoint(v2.pos, v0.pos)) {
-					continue;
-				}
+	// varyings are interpolated in floating point
+	mVaryingPlanes.varyingNum = 0;
+	if (varyingNum > 0) {
+		const FixedVertex& v0 = fixedVertices->At<FixedVertex>(setup.GetVertexIndex(0, triangle));
+		const FixedVertex& v1 = fixedVertices->At<FixedVertex>(setup.GetVertexIndex(1, triangle));
+		const FixedVertex& v2 = fixedVertices->At<FixedVertex>(setup.GetVertexIndex(2, triangle));
+		mVaryingPlanes.Setup(varyingNum, v0.pos.ToVec4(), v0.varyings, v1.pos.ToVec4(), v1.varyings, v2.pos.ToVec4(), v2.varyings);
+	}
+}
 
-				DF bary01 = edge01 / mTriSizeMul2;
-				DF bary12 = edge12 / mTriSizeMul2;
-				DF bary20 = edge20 / mTriSizeMul2;
-
-				Vec4 pos = Vec4::ZERO;
-				pos.x = x.ToFloat();
-				pos.y = y.ToFloat();
-				pos.w = bary12.ToDouble() / v0.pos.w.ToFloat()
-					+ bary20.ToDouble() / v1.pos.w.ToFloat()
-					+ bary01.ToDouble() / v2.pos.w.ToFloat();
-				pos.z = 1.0f / pos.w;
-
-				Pixel pixel;
-				pixel.pos = pos;
-				mPixels->Add(pixel);
-			}
+template<RasterizationType TYPE, typename FORMAT>
+inline bool RasterizeFixed<TYPE, FORMAT>::IsMicroTriangle(const TriangleSetup<FORMAT>& setup, uint32_t triangle, const ScissorRect& scissor) const
+{
+	if constexpr (IS_MICRO_TRIANGLE_ENABLED) {
+		int32_t minX, minY, maxX, maxY;
+		return setup.GetBBoxInScissor(triangle, scissor, &minX, &minY, &maxX, &maxY)
+			&& maxX - minX < MICRO_TRIANGLE_SIZE
+			&& maxY - minY < MICRO_TRIANGLE_SIZE;
+	}
+	else {
+		return false;
+	}
+}
 
-		}
+template<RasterizationType TYPE, typename FORMAT>
+void RasterizeFixed<TYPE, FORMAT>::RasterizeMicroTriangles(PixelOutput* pixels, const List* fixedVertices, const TriangleSetup<FORMAT>& setup,
+	const ScissorRect& scissor, uint32_t varyingNum)
+{
+	if constexpr (IS_MICRO_TRIANGLE_ENABLED) {
+		const static FP halfOne = FP(0.5f);
+		const Lanes zeroLanes = SetLanes(0);
 
-		// fixed number & normal rasterization
-#else
-		for (FP y = startY; y <= mMaxY; y += one) {
-			for (FP x = startX; x <= mMaxX; x += one) {
-				FixedVec4 pixelPos(x, y, FP::ZERO, FP::ZERO);
-				DF edge01 = EdgeFunction(pixelPos, v0.pos, v1.pos);
-				DF edge12 = EdgeFunction(pixelPos, v1.pos, v2.pos);
-				DF edge20 = EdgeFunction(pixelPos, v2.pos, v0.pos);
-
-				//TODO :  if ȭ
-				if (edge01 > DF::ZERO
-					|| edge12 > DF::ZERO
-					|| edge20 > DF::ZERO) {
-					continue;
+		uint32_t microTriangleNum = static_cast<uint32_t>(mMicroTriangles->GetSize());
+		if (microTriangleNum == 0) {
+			return;
+		}
+		assert(microTriangleNum <= LANE_NUM);
+
+		// edge values of left top pixel of bbox and their steps.
+		// bbox offset of empty lane is -1, so it has no candidate pixel
+		alignas(32) int32_t edges[EDGE_NUM][LANE_NUM];
+		alignas(32) int32_t xSteps[EDGE_NUM][LANE_NUM];
+		alignas(32) int32_t ySteps[EDGE_NUM][LANE_NUM];
+		alignas(32) int32_t maxXOffsets[LANE_NUM];
+		alignas(32) int32_t maxYOffsets[LANE_NUM];
+		uint32_t triangles[LANE_NUM];
+		FP leftXs[LANE_NUM];
+		FP topYs[LANE_NUM];
+		for (uint32_t lane = 0; lane < LANE_NUM; lane++) {
+			if (lane >= microTriangleNum) {
+				for (uint8_t e = 0; e < EDGE_NUM; e++) {
+					edges[e][lane] = 0;
+					xSteps[e][lane] = 0;
+					ySteps[e][lane] = 0;
 				}
+				maxXOffsets[lane] = -1;
+				maxYOffsets[lane] = -1;
+				continue;
+			}
 
-				if (edge01 == DF::ZERO
-					&& !IsLeftLine(v0.pos, v1.pos)
-					&& !IsTopLine(v0.pos, v1.pos)) {
-					continue;
+			uint32_t triangle = mMicroTriangles->At<uint32_t>(lane);
+			int32_t minX, minY, maxX, maxY;
+			setup.GetBBoxInScissor(triangle, scissor, &minX, &minY, &maxX, &maxY);
+			leftXs[lane] = FP(static_cast<float>(minX)) + halfOne;
+			topYs[lane] = FP(static_cast<float>(minY)) + halfOne;
+			for (uint8_t e = 0; e < EDGE_NUM; e++) {
+				edges[e][lane] = setup.EvaluateEdge(e, triangle, leftXs[lane], topYs[lane]).raw;
+				xSteps[e][lane] = setup.GetEdgeX(e, triangle).raw;
+				ySteps[e][lane] = setup.GetEdgeY(e, triangle).raw;
+			}
+			maxXOffsets[lane] = maxX - minX;
+			maxYOffsets[lane] = maxY - minY;
+			triangles[lane] = triangle;
+		}
+		mMicroTriangles->Reset(sizeof(uint32_t));
+
+		// test candidate pixels of bbox across lanes.
+		// bit (y * MICRO_TRIANGLE_SIZE + x) of coverage of lane is pixel (x, y) from left top of bbox
+		uint32_t coverages[LANE_NUM] = { 0, };
+		Lanes xStepLanes[EDGE_NUM];
+		Lanes yStepLanes[EDGE_NUM];
+		Lanes rowEdgeLanes[EDGE_NUM];
+		for (uint8_t e = 0; e < EDGE_NUM; e++) {
+			rowEdgeLanes[e] = LoadLanes(edges[e]);
+			xStepLanes[e] = LoadLanes(xSteps[e]);
+			yStepLanes[e] = LoadLanes(ySteps[e]);
+		}
+		Lanes maxXOffsetLanes = LoadLanes(maxXOffsets);
+		Lanes maxYOffsetLanes = LoadLanes(maxYOffsets);
+		for (int32_t y = 0; y < MICRO_TRIANGLE_SIZE; y++) {
+			Lanes edgeLanes[EDGE_NUM] = { rowEdgeLanes[0], rowEdgeLanes[1], rowEdgeLanes[2] };
+			Lanes isInBBoxY = CmpLessLanes(SetLanes(y - 1), maxYOffsetLanes);
+			for (int32_t x = 0; x < MICRO_TRIANGLE_SIZE; x++) {
+				Lanes isSelect = AndLanes(isInBBoxY, CmpLessLanes(SetLanes(x - 1), maxXOffsetLanes));
+				for (uint8_t e = 0; e < EDGE_NUM; e++) {
+					isSelect = AndLanes(isSelect, CmpLessLanes(edgeLanes[e], zeroLanes));
+					edgeLanes[e] = AddLanes(edgeLanes[e], xStepLanes[e]);
 				}
 
-				if (edge12 == DF::ZERO
-					&& !IsLeftLine(v1.pos, v2.pos)
-					&& !IsTopLine(v1.pos, v2.pos)) {
-					continue;
+				uint32_t laneMask = MaskLanes(isSelect);
+				for (uint32_t lane = 0; lane < LANE_NUM; lane++) {
+					coverages[lane] |= ((laneMask >> lane) & 1) << (y * MICRO_TRIANGLE_SIZE + x);
 				}
+			}
 
-				if (edge20 == DF::ZERO
-					&& !IsLeftLine(v2.pos, v0.pos)
-					&& !IsTopLine(v2.pos, v0.pos)) {
-					continue;
-				}
+			for (uint8_t e = 0; e < EDGE_NUM; e++) {
+				rowEdgeLanes[e] = AddLanes(rowEdgeLanes[e], yStepLanes[e]);
+			}
+		}
+
+		// interpolate covered pixels in order of triangles.
+		//		edge values of pixel are stepped from edge values of lane, not evaluated again
+		for (uint32_t lane = 0; lane < microTriangleNum; lane++) {
+			if (coverages[lane] == 0) {
+				continue;
+			}
 
-				DF bary01 = edge01 / mTriSizeMul2;
-				DF bary12 = edge12 / mTriSizeMul2;
-				DF bary20 = edge20 / mTriSizeMul2;
-
-				Vec4 pos = Vec4::ZERO;
-				pos.x = x.ToFloat();
-				pos.y = y.ToFloat();
-				pos.w = bary12.ToDouble() / v0.pos.w.ToFloat()
-					+ bary20.ToDouble() / v1.pos.w.ToFloat()
-					+ bary01.ToDouble() / v2.pos.w.ToFloat();
-				pos.z = 1.0f / pos.w;
-
-				Pixel pixel;
-				pixel.pos = pos;
-				pixels->Add(pixel);
+			LoadTriangle(fixedVertices, setup, triangles[lane], varyingNum);
+			for (uint64_t coverage = coverages[lane]; coverage != 0; coverage &= coverage - 1) {
+				uint32_t bit = LowestBitIndex(coverage);
+				uint32_t xIdx = bit % MICRO_TRIANGLE_SIZE;
+				uint32_t yIdx = bit / MICRO_TRIANGLE_SIZE;
+
+				DF pixelEdges[EDGE_NUM];
+				for (uint8_t e = 0; e < EDGE_NUM; e++) {
+					pixelEdges[e].raw = edges[e][lane] + static_cast<int32_t>(xIdx) * xSteps[e][lane] + static_cast<int32_t>(yIdx) * ySteps[e][lane];
+				}
+				AddPixel(pixels, leftXs[lane] + mBlockOffsets[xIdx], topYs[lane] + mBlockOffsets[yIdx], pixelEdges[0], pixelEdges[1], pixelEdges[2]);
 			}
 		}
-#endif
 	}
 }
 
-void RasterizeFixed::RasterizePart(
-	List* pixels,
-	const FixedVec4& v0Pos,
-	const FixedVec4& v1Pos,
-	const FixedVec4& v2Pos,
-	FP leftX,
-	FP topY,
-	uint8_t pixelLengthLog2,
-	DF edge01,
-	DF edge12,
-	DF edge20)
+template<RasterizationType TYPE, typename FORMAT>
+void RasterizeFixed<TYPE, FORMAT>::RasterizeTriangle(PixelOutput* pixels, const List* fixedVertices, const TriangleSetup<FORMAT>& setup, uint32_t triangle,
+	const ScissorRect& scissor, uint32_t varyingNum)
 {
-	// pixel length = 1
-	if (pixelLengthLog2 == 0) {
-		AddPixelIsInTriangle(pixels, v0Pos, v1Pos, v2Pos, leftX, topY, edge01, edge12, edge20);
-		return;
-	}
-	// pixel length 2
-	else if (pixelLengthLog2 == 1) {
-		AddPixelIsInTriangle(pixels, v0Pos, v1Pos, v2Pos, leftX, topY,
-			edge01, edge12, edge20);
-		AddPixelIsInTriangle(pixels, v0Pos, v1Pos, v2Pos, leftX + 1, topY,
-			edge01 + mDxEdge01s[0],
-			edge12 + mDxEdge12s[0],
-			edge20 + mDxEdge20s[0]);
-		AddPixelIsInTriangle(pixels, v0Pos, v1Pos, v2Pos, leftX, topY + 1,
-			edge01 + mDyEdge01s[0],
-			edge12 + mDyEdge12s[0],
-			edge20 + mDyEdge20s[0]);
-		AddPixelIsInTriangle(pixels, v0Pos, v1Pos, v2Pos, leftX + 1, topY + 1,
-			edge01 + mDxEdge01s[0] + mDyEdge01s[0],
-			edge12 + mDxEdge12s[0] + mDyEdge12s[0],
-			edge20 + mDxEdge20s[0] + mDyEdge20s[0]);
+	const static FP halfOne = FP(0.5f);
+	const static FP one = FP(1.0f);
 
+	// setup is shared by tiles, so its bbox is cut by scissor of tile
+	int32_t minX, minY, maxX, maxY;
+	if (setup.GetBBoxInScissor(triangle, scissor, &minX, &minY, &maxX, &maxY) == false) {
 		return;
 	}
 
-	// TODO : test advancing bary method
-	//			remove
-	//DF a = EdgeFunction(FixedVec4(leftX, topY, 0, 1), v0Pos, v1Pos);
-	//DF b = EdgeFunction(FixedVec4(leftX, topY, 0, 1), v1Pos, v2Pos);
-	//DF c = EdgeFunction(FixedVec4(leftX, topY, 0, 1), v2Pos, v0Pos);
-	//DF s = EdgeFunction(v0Pos, v1Pos, v2Pos);
-	//if (abs((a / s).ToDouble() - bary01.ToFloat()) > 0.01f
-	//	|| abs((b / s).ToDouble() - bary12.ToFloat()) > 0.01f
-	//	|| abs((c / s).ToDouble() - bary20.ToFloat()) > 0.01f) {
-	//	SetConsoleActiveScreenBuffer(GetStdHandle(STD_OUTPUT_HANDLE));
-	//	std::cout << "dif 01 : " << (a / s).ToDouble() << " " << bary01.ToFloat() << std::endl;
-	//	std::cout << "dif 12 : " << (b / s).ToDouble() << " " << bary12.ToFloat() << std::endl;
-	//	std::cout << "dif 20 : " << (c / s).ToDouble() << " " << bary20.ToFloat() << std::endl;
-	//	__debugbreak();
-	//}
-
-
-	// four corners don't inside triangle, divide pixel sqaure finely
-	DF rightTopEdge01 = edge01 + (mDxEdge01s[pixelLengthLog2] - mDxEdge01s[0]);
-	DF rightTopEdge12 = edge12 + (mDxEdge12s[pixelLengthLog2] - mDxEdge12s[0]);
-	DF rightTopEdge20 = edge20 + (mDxEdge20s[pixelLengthLog2] - mDxEdge20s[0]);
-
-	DF leftBottomEdge01 = edge01 + (mDyEdge01s[pixelLengthLog2] - mDyEdge01s[0]);
-	DF leftBottomEdge12 = edge12 + (mDyEdge12s[pixelLengthLog2] - mDyEdge12s[0]);
-	DF leftBottomEdge20 = edge20 + (mDyEdge20s[pixelLengthLog2] - mDyEdge20s[0]);
-
-	DF rightBottomEdge01 = edge01 + (mDxEdge01s[pixelLengthLog2] - mDxEdge01s[0]) + (mDyEdge01s[pixelLengthLog2] - mDyEdge01s[0]);
-	DF rightBottomEdge12 = edge12 + (mDxEdge12s[pixelLengthLog2] - mDxEdge12s[0]) + (mDyEdge12s[pixelLengthLog2] - mDyEdge12s[0]);
-	DF rightBottomEdge20 = edge20 + (mDxEdge20s[pixelLengthLog2] - mDxEdge20s[0]) + (mDyEdge20s[pixelLengthLog2] - mDyEdge20s[0]);
-
-	FP rightX = leftX + (1 << pixelLengthLog2) - 1;
-	FP bottomY = topY + (1 << pixelLengthLog2) - 1;
-
-	// TODO : think what is faster btw simd comp, contiguous || in if
-	bool isOutBBox = leftX < mMinX
-		|| rightX > mMaxX
-		|| topY < mMinY
-		|| bottomY > mMaxY;
-
-	// for not thinking top-left rule in 4*4, 8*8 pixel blocks in triangle,
-	// select only pixel blocks in triangle and not on triangle sides.
-	bool isOutOrOnTriangle = edge01 >= DF::ZERO
-		|| edge12 >= DF::ZERO
-		|| edge20 >= DF::ZERO
-		|| rightTopEdge01 >= DF::ZERO
-		|| rightTopEdge12 >= DF::ZERO
-		|| rightTopEdge20 >= DF::ZERO
-		|| leftBottomEdge01 >= DF::ZERO
-		|| leftBottomEdge12 >= DF::ZERO
-		|| leftBottomEdge20 >= DF::ZERO
-		|| rightBottomEdge01 >= DF::ZERO
-		|| rightBottomEdge12 >= DF::ZERO
-		|| rightBottomEdge20 >= DF::ZERO;
-
-	if (isOutBBox || isOutOrOnTriangle) {
-		uint8_t finePixelLengthLog2 = pixelLengthLog2 - 1;
-		FP finePixelLength(1 << finePixelLengthLog2);
-
-		RasterizePart(pixels, v0Pos, v1Pos, v2Pos, leftX, topY, finePixelLengthLog2,
-			edge01, edge12, edge20);
-		RasterizePart(pixels, v0Pos, v1Pos, v2Pos, leftX + finePixelLength, topY, finePixelLengthLog2,
-			edge01 + mDxEdge01s[finePixelLengthLog2],
-			edge12 + mDxEdge12s[finePixelLengthLog2],
-			edge20 + mDxEdge20s[finePixelLengthLog2]);
-		RasterizePart(pixels, v0Pos, v1Pos, v2Pos, leftX, topY + finePixelLength, finePixelLengthLog2,
-			edge01 + mDyEdge01s[finePixelLengthLog2],
-			edge12 + mDyEdge12s[finePixelLengthLog2],
-			edge20 + mDyEdge20s[finePixelLengthLog2]);
-		RasterizePart(pixels, v0Pos, v1Pos, v2Pos, leftX + finePixelLength, topY + finePixelLength, finePixelLengthLog2,
-			edge01 + mDxEdge01s[finePixelLengthLog2] + mDyEdge01s[finePixelLengthLog2],
-			edge12 + mDxEdge12s[finePixelLengthLog2] + mDyEdge12s[finePixelLengthLog2],
-			edge20 + mDxEdge20s[finePixelLengthLog2] + mDyEdge20s[finePixelLengthLog2]);
+	// depth of pixel is interpolated between depths of vertices, so it is never nearer than nearest vertex
+	mMinDepth = std::min(setup.GetVertexW(0, triangle), std::min(setup.GetVertexW(1, triangle), setup.GetVertexW(2, triangle)));
+	if (pixels->IsOccluded(minX, minY, maxX, maxY, mMinDepth)) {
 		return;
 	}
 
-	// add all pixels in four corners	
-	FP y = topY;
-	FP x = leftX;
-	DF yEdge01 = edge01;
-	DF yEdge12 = edge12;
-	DF yEdge20 = edge20;
-	uint8_t pixelLength = 1 << pixelLengthLog2;
-	for (uint8_t yIdx = 0; yIdx < pixelLength; yIdx++) {
-
-		DF xEdge01 = yEdge01;
-		DF xEdge12 = yEdge12;
-		DF xEdge20 = yEdge20;
-		for (uint8_t xIdx = 0; xIdx < pixelLength; xIdx++) {
-			// todo : create advanced partition rasterization in two methods
-			// 1. advanced edge differenece only pixel blocks in triangle and not on sides of triangle
-			// 2. add brances when pixel blocks include pixels on right or bottom sides of triangle
-
-			Pixel pixel;
-			pixel.pos = InterpolatePos(x,
-				y,
-				v0Pos,
-				v1Pos,
-				v2Pos,
-				xEdge01,
-				xEdge12,
-				xEdge20);
-			pixels->Add(pixel);
-
-
-			xEdge01 += mDxEdge01s[0];
-			xEdge12 += mDxEdge12s[0];
-			xEdge20 += mDxEdge20s[0];
-			x += FP::ONE;
+	mMinX = FP(static_cast<float>(minX)) + halfOne;
+	mMaxX = FP(static_cast<float>(maxX)) + halfOne;
+	mMinY = FP(static_cast<float>(minY)) + halfOne;
+	mMaxY = FP(static_cast<float>(maxY)) + halfOne;
+	LoadTriangle(fixedVertices, setup, triangle, varyingNum);
+
+	// fixed number & partition rasterization
+	if constexpr (TYPE == RasterizationType::Partition) {
+		SetupEdges(setup, triangle);
+
+		// traverse top level blocks which cover bbox
+		Block rowBlock;
+		rowBlock.leftX = mMinX;
+		rowBlock.topY = mMinY;
+		rowBlock.sizeLog2 = BLOCK_SIZE_LOG2;
+		for (uint8_t e = 0; e < EDGE_NUM; e++) {
+			rowBlock.edges[e] = setup.EvaluateEdge(e, triangle, mMinX, mMinY);
 		}
+		for (; rowBlock.topY <= mMaxY; rowBlock.topY += mBlockSteps[BLOCK_SIZE_LOG2]) {
+			Block block = rowBlock;
+			for (; block.leftX <= mMaxX; block.leftX += mBlockSteps[BLOCK_SIZE_LOG2]) {
+				TraverseBlock(pixels, block);
 
-		yEdge01 += mDyEdge01s[0];
-		yEdge12 += mDyEdge12s[0];
-		yEdge20 += mDyEdge20s[0];
+				for (uint8_t e = 0; e < EDGE_NUM; e++) {
+					block.edges[e] += mEdges[e].xSteps[BLOCK_SIZE_LOG2];
+				}
+			}
 
-		y += FP::ONE;
-		x = leftX;
+			for (uint8_t e = 0; e < EDGE_NUM; e++) {
+				rowBlock.edges[e] += mEdges[e].ySteps[BLOCK_SIZE_LOG2];
+			}
+		}
 	}
+	// fixed number & advanced rasterization
+	else if constexpr (TYPE == RasterizationType::Advanced) {
+		// step edge values by dx, dy without evaluating edge function on each pixel
+		SetupEdges(setup, triangle);
+
+		DF yEdge01 = setup.EvaluateEdge(0, triangle, mMinX, mMinY);
+		DF yEdge12 = setup.EvaluateEdge(1, triangle, mMinX, mMinY);
+		DF yEdge20 = setup.EvaluateEdge(2, triangle, mMinX, mMinY);
+		for (FP y = mMinY;
+			y <= mMaxY;
+			y += one,
+			yEdge01 += mEdges[0].ySteps[0],
+			yEdge12 += mEdges[1].ySteps[0],
+			yEdge20 += mEdges[2].ySteps[0])
+		{
+			DF xEdge01 = yEdge01;
+			DF xEdge12 = yEdge12;
+			DF xEdge20 = yEdge20;
+
+			for (FP x = mMinX;
+				x <= mMaxX;
+				x += one,
+				xEdge01 += mEdges[0].xSteps[0],
+				xEdge12 += mEdges[1].xSteps[0],
+				xEdge20 += mEdges[2].xSteps[0])
+			{
+				AddPixelIsInTriangle(pixels, x, y, xEdge01, xEdge12, xEdge20);
+			}
 
+		}
+	}
+	// fixed number & normal rasterization
+	else {
+		for (FP y = mMinY; y <= mMaxY; y += one) {
+			for (FP x = mMinX; x <= mMaxX; x += one) {
+				AddPixelIsInTriangle(pixels,
+					x,
+					y,
+					setup.EvaluateEdge(0, triangle, x, y),
+					setup.EvaluateEdge(1, triangle, x, y),
+					setup.EvaluateEdge(2, triangle, x, y));
+			}
+		}
+	}
 }
 
-inline void RasterizeFixed::AddPixelIsInTriangle(List* pixels, const FixedVec4& v0Pos, const FixedVec4& v1Pos, const FixedVec4& v2Pos, FP x, FP y, DF edge01, DF edge12, DF edge20)
+template<RasterizationType TYPE, typename FORMAT>
+void RasterizeFixed<TYPE, FORMAT>::SetupEdges(const TriangleSetup<FORMAT>& setup, uint32_t triangle)
 {
-	// out viewport
-	bool isOutBBox = x < mMinX
-		|| x >= mMaxX
-		|| y < mMinY
-		|| y >= mMaxY;
-	if (isOutBBox) {
-		return;
-	}
+	for (uint8_t e = 0; e < EDGE_NUM; e++) {
+		EdgeSetup& edge = mEdges[e];
+
+		// difference of edge value by 2^i x, 2^i y
+		edge.xSteps[0] = setup.GetEdgeX(e, triangle);
+		edge.ySteps[0] = setup.GetEdgeY(e, triangle);
+		for (uint8_t i = 1; i <= BLOCK_SIZE_LOG2; i++) {
+			edge.xSteps[i] = edge.xSteps[i - 1] + edge.xSteps[i - 1];
+			edge.ySteps[i] = edge.ySteps[i - 1] + edge.ySteps[i - 1];
+		}
 
-	// not in triangle
-	bool isSelect = IsSelectPixel(v0Pos, v1Pos, v2Pos, x, y, edge01, edge12, edge20);
-	if (isSelect == false) {
-		return;
+		// corners of 2^i block from its left top pixel.
+		// edge function is linear, so min, max of edge value in block are on corners
+		for (uint8_t i = 0; i <= BLOCK_SIZE_LOG2; i++) {
+			DF xCorner = edge.xSteps[i] - edge.xSteps[0];
+			DF yCorner = edge.ySteps[i] - edge.ySteps[0];
+			edge.rejectOffsets[i] = std::min(xCorner, DF::ZERO) + std::min(yCorner, DF::ZERO);
+			edge.acceptOffsets[i] = std::max(xCorner, DF::ZERO) + std::max(yCorner, DF::ZERO);
+		}
+
+		// difference of edge value by pixels in mask block
+		edge.xOffsets[0] = DF::ZERO;
+		edge.yOffsets[0] = DF::ZERO;
+		for (uint8_t i = 1; i < MAX_MASK_BLOCK_SIZE; i++) {
+			edge.xOffsets[i] = edge.xOffsets[i - 1] + edge.xSteps[0];
+			edge.yOffsets[i] = edge.yOffsets[i - 1] + edge.ySteps[0];
+		}
 	}
+}
 
+template<RasterizationType TYPE, typename FORMAT>
+void RasterizeFixed<TYPE, FORMAT>::TraverseBlock(PixelOutput* pixels, const Block& topBlock)
+{
+	// depth first traversal. dividing a block pops one and pushes four
+	Block stack[3 * BLOCK_SIZE_LOG2 + 1];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = topBlock;
+
+	while (stackSize > 0) {
+		Block block = stack[--stackSize];
+		uint8_t sizeLog2 = block.sizeLog2;
+
+		// classify block by corners of each edge.
+		//		out : min edge value of an edge is not selected
+		//		in : max edge values of all edges are selected
+		bool isOut = block.leftX > mMaxX || block.topY > mMaxY;
+		bool isIn = block.leftX + mBlockSteps[sizeLog2] - FP::ONE <= mMaxX
+			&& block.topY + mBlockSteps[sizeLog2] - FP::ONE <= mMaxY;
+		for (uint8_t e = 0; e < EDGE_NUM; e++) {
+			isOut |= block.edges[e] + mEdges[e].rejectOffsets[sizeLog2] >= DF::ZERO;
+			isIn &= block.edges[e] + mEdges[e].acceptOffsets[sizeLog2] < DF::ZERO;
+		}
 
-	Pixel pixel;
-	pixel.pos = InterpolatePos(x,
-		y,
-		v0Pos,
-		v1Pos,
-		v2Pos,
-		edge01,
-		edge12,
-		edge20);
+		if (isOut) {
+			continue;
+		}
 
+		// block is hidden by pixels drawn already
+		if (sizeLog2 > MASK_BLOCK_SIZE_LOG2) {
+			int32_t blockX = block.leftX.Floor();
+			int32_t blockY = block.topY.Floor();
+			int32_t blockSize = 1 << sizeLog2;
+			if (pixels->IsOccluded(blockX, blockY, blockX + blockSize - 1, blockY + blockSize - 1, mMinDepth)) {
+				continue;
+			}
+		}
 
-	pixels->Add(pixel);
-}
+		// all pixels are covered
+		if (isIn && sizeLog2 <= MAX_MASK_BLOCK_SIZE_LOG2 && mVaryingPlanes.varyingNum == 0) {
+			AddSpansInBlock(pixels, block);
+			continue;
+		}
+		if (isIn && sizeLog2 <= MAX_MASK_BLOCK_SIZE_LOG2) {
+			uint32_t pixelNum = 1 << (sizeLog2 * 2);
+			uint64_t mask = pixelNum == 64 ? ~0ULL : (1ULL << pixelNum) - 1;
+			AddPixelsInMask(pixels, block, mask);
+			continue;
+		}
 
-inline bool RasterizeFixed::IsSelectPixel(const FixedVec4& v0Pos, const FixedVec4& v1Pos, const FixedVec4& v2Pos, FP x, FP y, DF edge01, DF edge12, DF edge20)
-{
-	//TODO :  if ȭ
-	if (edge01 > DF::ZERO
-		|| edge12 > DF::ZERO
-		|| edge20 > DF::ZERO) {
-		return false;
+		// partially covered, test each pixel
+		if (isIn == false && sizeLog2 <= MASK_BLOCK_SIZE_LOG2) {
+			AddPixelsInMask(pixels, block, CalculateCoverageMask(block));
+			continue;
+		}
+
+		// divide to four blocks
+		uint8_t fineSizeLog2 = sizeLog2 - 1;
+		for (uint8_t i = 0; i < 4; i++) {
+			Block& fineBlock = stack[stackSize++];
+			fineBlock.leftX = (i & 1) ? block.leftX + mBlockSteps[fineSizeLog2] : block.leftX;
+			fineBlock.topY = (i & 2) ? block.topY + mBlockSteps[fineSizeLog2] : block.topY;
+			fineBlock.sizeLog2 = fineSizeLog2;
+			for (uint8_t e = 0; e < EDGE_NUM; e++) {
+				fineBlock.edges[e] = block.edges[e];
+				if (i & 1) {
+					fineBlock.edges[e] += mEdges[e].xSteps[fineSizeLog2];
+				}
+				if (i & 2) {
+					fineBlock.edges[e] += mEdges[e].ySteps[fineSizeLog2];
+				}
+			}
+		}
 	}
+}
 
+template<RasterizationType TYPE, typename FORMAT>
+inline uint64_t RasterizeFixed<TYPE, FORMAT>::CalculateCoverageMask(const Block& block) const
+{
+	uint8_t blockSize = 1 << block.sizeLog2;
+	uint64_t mask = 0;
+	for (uint8_t yIdx = 0; yIdx < blockSize; yIdx++) {
+		bool isInBBoxY = block.topY + mBlockOffsets[yIdx] <= mMaxY;
+		for (uint8_t xIdx = 0; xIdx < blockSize; xIdx++) {
+			// no branch on each edge
+			bool isSelect = isInBBoxY & (block.leftX + mBlockOffsets[xIdx] <= mMaxX);
+			for (uint8_t e = 0; e < EDGE_NUM; e++) {
+				DF edge = block.edges[e] + mEdges[e].xOffsets[xIdx] + mEdges[e].yOffsets[yIdx];
+				isSelect &= edge < DF::ZERO;
+			}
 
-	if (edge01 == DF::ZERO
-		&& !IsLeftLine(v0Pos, v1Pos)
-		&& !IsTopLine(v0Pos, v1Pos)) {
-		return false;
+			mask |= static_cast<uint64_t>(isSelect) << (yIdx * blockSize + xIdx);
+		}
 	}
 
-	if (edge12 == DF::ZERO
-		&& !IsLeftLine(v1Pos, v2Pos)
-		&& !IsTopLine(v1Pos, v2Pos)) {
-		return false;
-	}
+	return mask;
+}
 
-	if (edge20 == DF::ZERO
-		&& !IsLeftLine(v2Pos, v0Pos)
-		&& !IsTopLine(v2Pos, v0Pos)) {
-		return false;
+template<RasterizationType TYPE, typename FORMAT>
+inline void RasterizeFixed<TYPE, FORMAT>::AddPixelsInMask(PixelOutput* pixels, const Block& block, uint64_t mask)
+{
+	uint8_t xIdxMask = (1 << block.sizeLog2) - 1;
+	while (mask != 0) {
+		uint32_t bit = LowestBitIndex(mask);
+		mask &= mask - 1;
+
+		uint8_t xIdx = bit & xIdxMask;
+		uint8_t yIdx = bit >> block.sizeLog2;
+
+		Pixel pixel;
+		pixel.pos = InterpolatePos(block.leftX + mBlockOffsets[xIdx],
+			block.topY + mBlockOffsets[yIdx],
+			block.edges[0] + mEdges[0].xOffsets[xIdx] + mEdges[0].yOffsets[yIdx],
+			block.edges[1] + mEdges[1].xOffsets[xIdx] + mEdges[1].yOffsets[yIdx],
+			block.edges[2] + mEdges[2].xOffsets[xIdx] + mEdges[2].yOffsets[yIdx]);
+		mVaryingPlanes.Interpolate(pixel.varyings, pixel.pos.x, pixel.pos.y, pixel.pos.z);
+		pixel.materialID = mMaterialID;
+		pixels->Add(pixel);
 	}
-
-	return true;
 }
 
+template<RasterizationType TYPE, typename FORMAT>
+inline void RasterizeFixed<TYPE, FORMAT>::AddSpansInBlock(PixelOutput* pixels, const Block& block)
+{
+	// 1 / w is evaluated once per row, pixels of row are restored from it
+	uint8_t blockSize = 1 << block.sizeLog2;
+	Span span;
+	span.leftX = block.leftX.Floor();
+	span.length = blockSize;
+	span.invWDx = static_cast<float>(mInvWDx);
+	span.materialID = mMaterialID;
+	for (uint8_t yIdx = 0; yIdx < blockSize; yIdx++) {
+		double invW = 0.0;
+		for (uint8_t e = 0; e < EDGE_NUM; e++) {
+			invW += (block.edges[e] + mEdges[e].yOffsets[yIdx]).ToDouble() * mInvWEdges[e];
+		}
 
+		span.y = (block.topY + mBlockOffsets[yIdx]).Floor();
+		span.invW = static_cast<float>(invW);
+		pixels->AddSpan(span);
+	}
+}
 
-inline bool RasterizeFixed::IsLeftLine(const FixedVec4& prePos, const FixedVec4& nextPos) const
+template<RasterizationType TYPE, typename FORMAT>
+inline void RasterizeFixed<TYPE, FORMAT>::AddPixelIsInTriangle(PixelOutput* pixels, FP x, FP y, DF edge01, DF edge12, DF edge20)
 {
-	return (nextPos - prePos).y < 0;
+	// not in triangle
+	if (IsSelectPixel(edge01, edge12, edge20) == false) {
+		return;
+	}
+
+	AddPixel(pixels, x, y, edge01, edge12, edge20);
 }
 
-inline bool RasterizeFixed::IsTopLine(const FixedVec4& prePos, const FixedVec4& nextPos) const
+template<RasterizationType TYPE, typename FORMAT>
+inline void RasterizeFixed<TYPE, FORMAT>::AddPixel(PixelOutput* pixels, FP x, FP y, DF edge01, DF edge12, DF edge20)
 {
-	return ((nextPos - prePos).y == 0) && ((nextPos - prePos).x > 0);
-}
+	Pixel pixel;
+	pixel.pos = InterpolatePos(x,
+		y,
+		edge01,
+		edge12,
+		edge20);
+	mVaryingPlanes.Interpolate(pixel.varyings, pixel.pos.x, pixel.pos.y, pixel.pos.z);
+	pixel.materialID = mMaterialID;
 
+	pixels->Add(pixel);
+}
 
-inline Vec4 RasterizeFixed::InterpolatePos(
+template<RasterizationType TYPE, typename FORMAT>
+inline Vec4 RasterizeFixed<TYPE, FORMAT>::InterpolatePos(
 	FP x,
 	FP y,
-	const FixedVec4& v0Pos,
-	const FixedVec4& v1Pos,
-	const FixedVec4& v2Pos,
 	DF edge01,
 	DF edge12,
 	DF edge20) const
 {
-	DF bary01 = edge01 / mTriSizeMul2;
-	DF bary12 = edge12 / mTriSizeMul2;
-	DF bary20 = edge20 / mTriSizeMul2;
+	double bary01 = edge01.ToDouble() * mInvTriSizeMul2;
+	double bary12 = edge12.ToDouble() * mInvTriSizeMul2;
+	double bary20 = edge20.ToDouble() * mInvTriSizeMul2;
 
 
 	Vec4 pos = Vec4::ZERO;
 	pos.x = x.ToFloat();
 	pos.y = y.ToFloat();
 
-	pos.w = static_cast<float>(edge12.ToDouble()) / v0Pos.w.ToFloat()
-		+ static_cast<float>(edge20.ToDouble()) / v1Pos.w.ToFloat()
-		+ static_cast<float>(edge01.ToDouble()) / v2Pos.w.ToFloat();
+	pos.w = static_cast<float>(bary12) / mVertexWs[0]
+		+ static_cast<float>(bary20) / mVertexWs[1]
+		+ static_cast<float>(bary01) / mVertexWs[2];
 
 	pos.z = 1.0f / pos.w;
 
 	return pos;
 }
+
+template class RasterizeFixed<RasterizationType::Normal, WideFixedPointFormat>;
+template class RasterizeFixed<RasterizationType::Partition, WideFixedPointFormat>;
+template class RasterizeFixed<RasterizationType::Advanced, WideFixedPointFormat>;
+template class RasterizeFixed<RasterizationType::Normal, NarrowFixedPointFormat>;
+template class RasterizeFixed<RasterizationType::Partition, NarrowFixedPointFormat>;
+template class RasterizeFixed<RasterizationType::Advanced, NarrowFixedPointFormat>;
\ No newline at end of file
@@ -1,87 +1,132 @@
 #pragma once
+#include <type_traits>
 #include "IRasterizable.h"
 #include "Primitive.h"
+#include "VaryingPlanes.h"
+#include "TriangleSetup.h"
 
-class RasterizeFixed : public IRasterizable {
+// FORMAT : FixedPointFormat which positions are converted to and edge functions are evaluated in
+template<RasterizationType TYPE, typename FORMAT>
+class RasterizeFixed : public ISetupRasterizable {
 public:
-	virtual void Rasterize(List* pixels, const List* fixedVertices, const List* indices) override;
-	virtual ~RasterizeFixed() override {}
+	typedef typename FORMAT::FP FP;
+	typedef typename FORMAT::DF DF;
+	typedef typename FORMAT::FixedVec4 FixedVec4;
+
+	// partition traversal starts with blocks of 2^BLOCK_SIZE_LOG2 pixels,
+	// and divides partially covered blocks until 2^MASK_BLOCK_SIZE_LOG2 pixels whose coverage is tested per pixel
+	static constexpr uint8_t BLOCK_SIZE_LOG2 = 3;
+	static constexpr uint8_t MASK_BLOCK_SIZE_LOG2 = 2;
 
 private:
-	inline DF EdgeFunction(const FixedVec4& pixelPos, const FixedVec4& v0Pos, const FixedVec4& v1Pos) const
-	{
-		FixedVec4 pMinusV0 = pixelPos - v0Pos;
-		FixedVec4 v1MinusV0 = v1Pos - v0Pos;
+	// coverage of a block up to 8*8 pixels fits in 64 bits mask
+	static constexpr uint8_t MAX_MASK_BLOCK_SIZE_LOG2 = 3;
+	static constexpr uint8_t MAX_MASK_BLOCK_SIZE = 1 << MAX_MASK_BLOCK_SIZE_LOG2;
+	static_assert(MASK_BLOCK_SIZE_LOG2 <= BLOCK_SIZE_LOG2, "mask block can't be bigger than top level block");
+	static_assert(MASK_BLOCK_SIZE_LOG2 <= MAX_MASK_BLOCK_SIZE_LOG2, "mask block must fit in 64 bits");
 
-		DF v0PX = pMinusV0.x.ToDoubleFixedPoint();
-		DF v0V1Y = v1MinusV0.y.ToDoubleFixedPoint();
-		DF v0PY = pMinusV0.y.ToDoubleFixedPoint();
-		DF v0V1X = v1MinusV0.x.ToDoubleFixedPoint();
+	// triangles whose bbox is MICRO_TRIANGLE_SIZE * MICRO_TRIANGLE_SIZE pixels or smaller
+	// skip per triangle traversal, and are tested in groups, a triangle per SIMD lane.
+	// only advanced rasterization has it, and only edge values in 32 bits fit in lanes
+	static constexpr int32_t MICRO_TRIANGLE_SIZE = 2;
+	static constexpr bool IS_MICRO_TRIANGLE_ENABLED = TYPE == RasterizationType::Advanced && std::is_same_v<typename DF::Raw, int32_t>;
+	// a group of lanes at most
+	static constexpr uint64_t RESERVED_MICRO_TRIANGLE_NUM = 8;
 
-		return v0PX * v0V1Y - v0PY * v0V1X;
-	}
+	// edge 01, 12, 20
+	static constexpr uint8_t EDGE_NUM = TriangleSetup<FORMAT>::EDGE_NUM;
 
-	void RasterizePart(
-		List* pixels,
-		const FixedVec4& v0Pos,
-		const FixedVec4& v1Pos,
-		const FixedVec4& v2Pos,
-		FP leftX,
-		FP topY,
-		uint8_t pixelLengthLog2,
-		DF edge01,
-		DF edge12,
-		DF edge20);
+	struct EdgeSetup {
+		// edge value difference by 2^i x, 2^i y
+		DF xSteps[BLOCK_SIZE_LOG2 + 1];
+		DF ySteps[BLOCK_SIZE_LOG2 + 1];
+		// from left top pixel of 2^i block to the corner which has min (rejection), max (acceptance) edge value
+		DF rejectOffsets[BLOCK_SIZE_LOG2 + 1];
+		DF acceptOffsets[BLOCK_SIZE_LOG2 + 1];
+		// edge value difference by i x, i y in a mask block
+		DF xOffsets[MAX_MASK_BLOCK_SIZE];
+		DF yOffsets[MAX_MASK_BLOCK_SIZE];
+	};
 
-	inline void AddPixelIsInTriangle(
-		List* pixels,
-		const FixedVec4& v0Pos,
-		const FixedVec4& v1Pos,
-		const FixedVec4& v2Pos,
-		FP x,
-		FP y,
-		DF edge01,
-		DF edge12,
-		DF edge20);
+	struct Block {
+		// center of left top pixel
+		FP leftX;
+		FP topY;
+		uint8_t sizeLog2;
+		// edge values of left top pixel
+		DF edges[EDGE_NUM];
+	};
 
-	inline bool IsSelectPixel(
-		const FixedVec4& v0Pos,
-		const FixedVec4& v1Pos,
-		const FixedVec4& v2Pos,
-		FP x,
-		FP y,
-		DF edge01,
-		DF edge12,
-		DF edge20
-	);
+public:
+	RasterizeFixed();
+	virtual void Rasterize(PixelOutput* pixels, const List* fixedVertices, const TriangleSetupBase& setup, const List* triangles, const ScissorRect& scissor,
+		uint32_t varyingNum) override;
+	virtual ~RasterizeFixed() override;
+
+private:
+	// traverse pixels of triangle in setup, which are in scissor.
+	//		state of traversal is in this rasterizer, setup is only read
+	void RasterizeTriangle(PixelOutput* pixels, const List* fixedVertices, const TriangleSetup<FORMAT>& setup, uint32_t triangle,
+		const ScissorRect& scissor, uint32_t varyingNum);
+
+	// interpolation state of triangle in setup
+	void LoadTriangle(const List* fixedVertices, const TriangleSetup<FORMAT>& setup, uint32_t triangle, uint32_t varyingNum);
+
+	inline bool IsMicroTriangle(const TriangleSetup<FORMAT>& setup, uint32_t triangle, const ScissorRect& scissor) const;
+	// rasterize gathered micro triangles, a group of lanes at most, in order they are gathered
+	void RasterizeMicroTriangles(PixelOutput* pixels, const List* fixedVertices, const TriangleSetup<FORMAT>& setup,
+		const ScissorRect& scissor, uint32_t varyingNum);
+
+	void SetupEdges(const TriangleSetup<FORMAT>& setup, uint32_t triangle);
 
-	inline bool IsLeftLine(const FixedVec4& prePos, const FixedVec4& nextPos) const;
-	inline bool IsTopLine(const FixedVec4& prePos, const FixedVec4& nextPos) const;
+	void TraverseBlock(PixelOutput* pixels, const Block& topBlock);
 
+	inline uint64_t CalculateCoverageMask(const Block& block) const;
+
+	// bit (y * block size + x) of mask is pixel (x, y) in block
+	inline void AddPixelsInMask(PixelOutput* pixels, const Block& block, uint64_t mask);
+	// rows of fully covered block without varyings are added as spans
+	inline void AddSpansInBlock(PixelOutput* pixels, const Block& block);
+
+	inline void AddPixelIsInTriangle(PixelOutput* pixels, FP x, FP y, DF edge01, DF edge12, DF edge20);
+	// pixel which is in triangle already
+	inline void AddPixel(PixelOutput* pixels, FP x, FP y, DF edge01, DF edge12, DF edge20);
+
+	// edge values are biased by top-left rule in setup, so no tie-breaking on edge
+	inline bool IsSelectPixel(DF edge01, DF edge12, DF edge20) const {
+		return (edge01 < DF::ZERO) & (edge12 < DF::ZERO) & (edge20 < DF::ZERO);
+	}
 
 	inline Vec4 InterpolatePos(
 		FP x,
 		FP y,
-		const FixedVec4& v0Pos,
-		const FixedVec4& v1Pos,
-		const FixedVec4& v2Pos,
 		DF edge01,
 		DF edge12,
 		DF edge20) const;
 
 private:
-	// dxEdgeFunctionValue, 2 * dxEdgeFunctionValue, 4 * dxEdgeFunctionValue, 8 * dxEdgeFunctionValue
-	DF mDxEdge01s[4];
-	DF mDxEdge12s[4];
-	DF mDxEdge20s[4];
-	// dyEdgeFunctionValue, 2 * dyEdgeFunctionValue, 4 * dyEdgeFunctionValue, 8 * dyEdgeFunctionValue
-	DF mDyEdge01s[4];
-	DF mDyEdge12s[4]; 
-	DF mDyEdge20s[4];
-
-	DF mTriSizeMul2;
-
-	// bbox covers triangle
+	// indices of micro triangles in setup, gathered until lanes are full or a larger triangle comes
+	List* mMicroTriangles = nullptr;
+
+	EdgeSetup mEdges[EDGE_NUM];
+	// 2^i, i in fixed point
+	FP mBlockSteps[BLOCK_SIZE_LOG2 + 1];
+	FP mBlockOffsets[MAX_MASK_BLOCK_SIZE];
+
+	// triangle being traversed, loaded from setup
+	//		edge values are multiplied by it for barycentric coordinates in floating point,
+	//		so their precision doesn't depend on FORMAT
+	double mInvTriSizeMul2 = 0.0;
+	// w of vertices. depth is interpolated in floating point too
+	float mVertexWs[3];
+	// 1 / w is sum of edge value * mInvWEdges, and its difference by 1 x is mInvWDx
+	double mInvWEdges[EDGE_NUM];
+	double mInvWDx = 0.0;
+	// depth of nearest vertex
+	float mMinDepth = 0.0f;
+	VaryingPlanes mVaryingPlanes;
+	uint32_t mMaterialID = 0;
+	// centers of left top, right bottom pixels of bbox
 	FP mMinX = FP::ZERO;
 	FP mMaxX = FP::ZERO;
 	FP mMinY = FP::ZERO;
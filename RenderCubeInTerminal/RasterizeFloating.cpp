@@ -1,145 +1,516 @@
 #include "RasterizeFloating.h"
+#include <immintrin.h>
 
-void RasterizeFloating::Rasterize(List* pixels, const List* floatingVertices, const List* indices)
+// lanes of edge function kernel. AVX2 evaluates 8 pixels, SSE evaluates 4 pixels at once
+#ifdef __AVX2__
+typedef __m256 Lanes;
+static constexpr uint32_t LANE_NUM = 8;
+
+static inline Lanes SetLanes(float value) { return _mm256_set1_ps(value); }
+static inline Lanes AllOneLanes() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+static inline Lanes LaneOffsetLanes() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+static inline Lanes AddLanes(Lanes lhs, Lanes rhs) { return _mm256_add_ps(lhs, rhs); }
+static inline Lanes SubLanes(Lanes lhs, Lanes rhs) { return _mm256_sub_ps(lhs, rhs); }
+static inline Lanes MulLanes(Lanes lhs, Lanes rhs) { return _mm256_mul_ps(lhs, rhs); }
+static inline Lanes DivLanes(Lanes lhs, Lanes rhs) { return _mm256_div_ps(lhs, rhs); }
+static inline Lanes AndLanes(Lanes lhs, Lanes rhs) { return _mm256_and_ps(lhs, rhs); }
+static inline Lanes OrLanes(Lanes lhs, Lanes rhs) { return _mm256_or_ps(lhs, rhs); }
+static inline Lanes CmpLessLanes(Lanes lhs, Lanes rhs) { return _mm256_cmp_ps(lhs, rhs, _CMP_LT_OQ); }
+static inline Lanes CmpLessEqualLanes(Lanes lhs, Lanes rhs) { return _mm256_cmp_ps(lhs, rhs, _CMP_LE_OQ); }
+static inline Lanes CmpEqualLanes(Lanes lhs, Lanes rhs) { return _mm256_cmp_ps(lhs, rhs, _CMP_EQ_OQ); }
+static inline uint32_t MaskLanes(Lanes lanes) { return static_cast<uint32_t>(_mm256_movemask_ps(lanes)); }
+static inline void StoreLanes(float* dst, Lanes lanes) { _mm256_store_ps(dst, lanes); }
+
+// edge values of lanes are stepped in double and rounded to lanes. rounding keeps sign and zero of them
+struct EdgeOffsets {
+	__m256d low;
+	__m256d high;
+};
+
+static inline EdgeOffsets SetEdgeOffsets(double dxEdge)
+{
+	__m256d dxEdges = _mm256_set1_pd(dxEdge);
+	return { _mm256_mul_pd(_mm256_setr_pd(0.0, 1.0, 2.0, 3.0), dxEdges), _mm256_mul_pd(_mm256_setr_pd(4.0, 5.0, 6.0, 7.0), dxEdges) };
+}
+
+static inline Lanes EdgeLanes(double edge, const EdgeOffsets& offsets)
 {
+	__m256d edges = _mm256_set1_pd(edge);
+	__m128 low = _mm256_cvtpd_ps(_mm256_add_pd(edges, offsets.low));
+	__m128 high = _mm256_cvtpd_ps(_mm256_add_pd(edges, offsets.high));
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+}
+#else
+typedef __m128 Lanes;
+static constexpr uint32_t LANE_NUM = 4;
+
+static inline Lanes SetLanes(float value) { return _mm_set1_ps(value); }
+static inline Lanes AllOneLanes() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+static inline Lanes LaneOffsetLanes() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+static inline Lanes AddLanes(Lanes lhs, Lanes rhs) { return _mm_add_ps(lhs, rhs); }
+static inline Lanes SubLanes(Lanes lhs, Lanes rhs) { return _mm_sub_ps(lhs, rhs); }
+static inline Lanes MulLanes(Lanes lhs, Lanes rhs) { return _mm_mul_ps(lhs, rhs); }
+static inline Lanes DivLanes(Lanes lhs, Lanes rhs) { return _mm_div_ps(lhs, rhs); }
+static inline Lanes AndLanes(Lanes lhs, Lanes rhs) { return _mm_and_ps(lhs, rhs); }
+static inline Lanes OrLanes(Lanes lhs, Lanes rhs) { return _mm_or_ps(lhs, rhs); }
+static inline Lanes CmpLessLanes(Lanes lhs, Lanes rhs) { return _mm_cmplt_ps(lhs, rhs); }
+static inline Lanes CmpLessEqualLanes(Lanes lhs, Lanes rhs) { return _mm_cmple_ps(lhs, rhs); }
+static inline Lanes CmpEqualLanes(Lanes lhs, Lanes rhs) { return _mm_cmpeq_ps(lhs, rhs); }
+static inline uint32_t MaskLanes(Lanes lanes) { return static_cast<uint32_t>(_mm_movemask_ps(lanes)); }
+static inline void StoreLanes(float* dst, Lanes lanes) { _mm_store_ps(dst, lanes); }
+
+// edge values of lanes are stepped in double and rounded to lanes. rounding keeps sign and zero of them
+struct EdgeOffsets {
+	__m128d low;
+	__m128d high;
+};
+
+static inline EdgeOffsets SetEdgeOffsets(double dxEdge)
+{
+	__m128d dxEdges = _mm_set1_pd(dxEdge);
+	return { _mm_mul_pd(_mm_setr_pd(0.0, 1.0), dxEdges), _mm_mul_pd(_mm_setr_pd(2.0, 3.0), dxEdges) };
+}
+
+static inline Lanes EdgeLanes(double edge, const EdgeOffsets& offsets)
+{
+	__m128d edges = _mm_set1_pd(edge);
+	return _mm_movelh_ps(_mm_cvtpd_ps(_mm_add_pd(edges, offsets.low)), _mm_cvtpd_ps(_mm_add_pd(edges, offsets.high)));
+}
+#endif
+
+static inline uint32_t LowestBitIndex(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+template<RasterizationType TYPE>
+void RasterizeFloating<TYPE>::Rasterize(PixelOutput* pixels, const List* floatingVertices, const List* indices, const List* materialIDs, const ScissorRect& scissor,
+	uint32_t varyingNum)
+{
+	const float scissorMinX = static_cast<float>(scissor.leftX);
+	const float scissorMaxX = static_cast<float>(scissor.rightX);
+	const float scissorMinY = static_cast<float>(scissor.topY);
+	const float scissorMaxY = static_cast<float>(scissor.bottomY);
+
 	uint64_t indexLen = indices->GetSize();
 	for (int indexIdx = 0; indexIdx < indexLen; indexIdx += 3) {
 		Vertex v0 = floatingVertices->At<Vertex>(indices->At<uint32_t>(indexIdx));
 		Vertex v1 = floatingVertices->At<Vertex>(indices->At<uint32_t>(indexIdx + 1));
 		Vertex v2 = floatingVertices->At<Vertex>(indices->At<uint32_t>(indexIdx + 2));
 
+		// snap positions to sub pixel grid, so edge values stay exact in double (see SUB_PIXEL_BITS)
+		SnapToSubPixel(v0.pos);
+		SnapToSubPixel(v1.pos);
+		SnapToSubPixel(v2.pos);
+
 		// calculate bbox covers triangle
-		float minX = min(v0.pos.x, min(v1.pos.x, v2.pos.x));
-		float maxX = max(v0.pos.x, max(v1.pos.x, v2.pos.x));
-		float minY = min(v0.pos.y, min(v1.pos.y, v2.pos.y));
-		float maxY = max(v0.pos.y, max(v1.pos.y, v2.pos.y));
+		mMinX = std::min(v0.pos.x, std::min(v1.pos.x, v2.pos.x));
+		mMaxX = std::max(v0.pos.x, std::max(v1.pos.x, v2.pos.x));
+		mMinY = std::min(v0.pos.y, std::min(v1.pos.y, v2.pos.y));
+		mMaxY = std::max(v0.pos.y, std::max(v1.pos.y, v2.pos.y));
 
-		float minXFloor = floor(minX);
-		float minYFloor = floor(minY);
-		float startX = minX - minXFloor > 0.5f ? minXFloor + 1.5f : minXFloor + 0.5f;
-		float startY = minY - minYFloor > 0.5f ? minYFloor + 1.5f : minYFloor + 0.5f;
+		// limit bbox to scissor
+		mMinX = std::max(mMinX, scissorMinX);
+		mMaxX = std::min(mMaxX, scissorMaxX);
+		mMinY = std::max(mMinY, scissorMinY);
+		mMaxY = std::min(mMaxY, scissorMaxY);
+		if (mMinX > mMaxX || mMinY > mMaxY) {
+			continue;
+		}
 
-		float triSizeMul2 = (v2.pos.x - v0.pos.x) * (v1.pos.y - v0.pos.y) - (v2.pos.y - v0.pos.y) * (v1.pos.x - v0.pos.x);
+		float minXFloor = floor(mMinX);
+		float minYFloor = floor(mMinY);
+		float startX = mMinX - minXFloor > 0.5f ? minXFloor + 1.5f : minXFloor + 0.5f;
+		float startY = mMinY - minYFloor > 0.5f ? minYFloor + 1.5f : minYFloor + 0.5f;
+		Vec4 startPos(startX, startY, 0.0f, 0.0f);
 
-#if RASTERIZATION_TYPE == NORMAL_RASTERIZATION
-		for (float y = startY; y <= maxY; y += 1.0f) {
-			for (float x = startX; x <= maxX; x += 1.0f) {
+		// pre calculate 2 * triangle size
+		double triSizeMul2 = EdgeFunctionFloatingPoint(v0.pos, v1.pos, v2.pos);
+		if (triSizeMul2 == 0.0) {
+			continue;
+		}
+		mTriSizeMul2 = static_cast<float>(triSizeMul2);
 
-				float edge01;
-				float edge12;
-				float edge20;
+		// depth of pixel is interpolated between depths of vertices, so it is never nearer than nearest vertex
+		mMinDepth = std::min(v0.pos.w, std::min(v1.pos.w, v2.pos.w));
+		if (pixels->IsOccluded(
+			static_cast<int32_t>(minXFloor), static_cast<int32_t>(minYFloor),
+			static_cast<int32_t>(floor(mMaxX - 0.5f)), static_cast<int32_t>(floor(mMaxY - 0.5f)),
+			mMinDepth)) {
+			continue;
+		}
 
-				edge01 = (x - v0.pos.x) * (v1.pos.y - v0.pos.y) - (y - v0.pos.y) * (v1.pos.x - v0.pos.x);
-				edge12 = (x - v1.pos.x) * (v2.pos.y - v1.pos.y) - (y - v1.pos.y) * (v2.pos.x - v1.pos.x);
-				edge20 = (x - v2.pos.x) * (v0.pos.y - v2.pos.y) - (y - v2.pos.y) * (v0.pos.x - v2.pos.x);
+		mVaryingPlanes.Setup(varyingNum, v0.pos, v0.varyings, v1.pos, v1.varyings, v2.pos, v2.varyings);
+		mMaterialID = materialIDs != nullptr ? materialIDs->At<uint32_t>(indexIdx / 3) : 0;
 
-				if (edge01 == edge12 && edge12 == edge20) {
-					__debugbreak();
-				}
+		// pre calculate difference of edge value by 2^i x, 2^i y
+		mDxEdge01s[0] = static_cast<double>(v1.pos.y) - v0.pos.y;
+		mDxEdge12s[0] = static_cast<double>(v2.pos.y) - v1.pos.y;
+		mDxEdge20s[0] = static_cast<double>(v0.pos.y) - v2.pos.y;
+		mDyEdge01s[0] = static_cast<double>(v0.pos.x) - v1.pos.x;
+		mDyEdge12s[0] = static_cast<double>(v1.pos.x) - v2.pos.x;
+		mDyEdge20s[0] = static_cast<double>(v2.pos.x) - v0.pos.x;
+		for (int i = 1; i <= 3; i++) {
+			mDxEdge01s[i] = mDxEdge01s[0] * (1 << i);
+			mDxEdge12s[i] = mDxEdge12s[0] * (1 << i);
+			mDxEdge20s[i] = mDxEdge20s[0] * (1 << i);
 
-				// edge function
-				// = (x - v0.x) * (v1.y - v0.y) - (y - v0.y) * (v1.x - v0.x)
-				// = (eA[0] - eA[1]) * (eA[2] - eA[3]) - (eA[4] - eA[5]) * (eA[6] - eA[7])
-				// = eB[0] * eB[1] - eB[2] * eB[3]
-				// = eC[0] - eC[1]
-				// = edge
-
-				__declspec(align(16)) float eA01[8]{x, v0.pos.x, v1.pos.y, v0.pos.y, y, v0.pos.y, v1.pos.x, v0.pos.x};
-				__declspec(align(16)) float eA12[8]{x, v1.pos.x, v2.pos.y, v1.pos.y, y, v1.pos.y, v2.pos.x, v1.pos.x};
-				__declspec(align(16)) float eA20[8]{x, v2.pos.x, v0.pos.y, v2.pos.y, y, v2.pos.y, v0.pos.x, v2.pos.x};
-				__declspec(align(16)) float eB01[4];
-				__declspec(align(16)) float eB12[4];
-				__declspec(align(16)) float eB20[4];
-				__declspec(align(16)) float eC01[2];
-				__declspec(align(16)) float eC12[2];
-				__declspec(align(16)) float eC20[2];
-
-				eB01[0] = eA01[0] - eA01[1];
-				eB01[1] = eA01[2] - eA01[3];
-				eB01[2] = eA01[4] - eA01[5];
-				eB01[3] = eA01[6] - eA01[7];
-				
-				eB12[0] = eA12[0] - eA12[1];
-				eB12[1] = eA12[2] - eA12[3];
-				eB12[2] = eA12[4] - eA12[5];
-				eB12[3] = eA12[6] - eA12[7];
-				
-				eB20[0] = eA20[0] - eA20[1];
-				eB20[1] = eA20[2] - eA20[3];
-				eB20[2] = eA20[4] - eA20[5];
-				eB20[3] = eA20[6] - eA20[7];
-								
-				eC01[0] = eB01[0] * eB01[1];
-				eC01[1] = eB01[2] * eB01[3];
-				eC12[0] = eB12[0] * eB12[1];
-				eC12[1] = eB12[2] * eB12[3];
-				eC20[0] = eB20[0] * eB20[1];
-				eC20[1] = eB20[2] * eB20[3];
-
-				edge01 = eC01[0] - eC01[1];
-				edge12 = eC12[0] - eC12[1];
-				edge20 = eC20[0] - eC20[1];
-
-				
-
-				//TODO :  if ȭ
-				if (edge01 > 0
-					|| edge12 > 0
-					|| edge20 > 0) {
-					continue;
-				}
+			mDyEdge01s[i] = mDyEdge01s[0] * (1 << i);
+			mDyEdge12s[i] = mDyEdge12s[0] * (1 << i);
+			mDyEdge20s[i] = mDyEdge20s[0] * (1 << i);
+		}
 
+		if constexpr (TYPE == RasterizationType::Normal) {
+			// edge function evaluates LANE_NUM pixel centers in a row at once.
+			// edge value of first lane steps by LANE_NUM * dx in double, and lanes are offset from it
+			EdgeOffsets edge01Offsets = SetEdgeOffsets(mDxEdge01s[0]);
+			EdgeOffsets edge12Offsets = SetEdgeOffsets(mDxEdge12s[0]);
+			EdgeOffsets edge20Offsets = SetEdgeOffsets(mDxEdge20s[0]);
+			double stepEdge01 = mDxEdge01s[0] * LANE_NUM;
+			double stepEdge12 = mDxEdge12s[0] * LANE_NUM;
+			double stepEdge20 = mDxEdge20s[0] * LANE_NUM;
 
-				if (edge01 == DF::ZERO
-					&& !IsLeftLineFloatingPoint(v0.pos, v1.pos)
-					&& !IsTopLineFloatingPoint(v0.pos, v1.pos)) {
-					continue;
-				}
+			// pixel on edge is selected only when the edge is left or top line
+			Lanes zeroLanes = SetLanes(0.0f);
+			Lanes onEdge01Lanes = IsLeftLineFloatingPoint(v0.pos, v1.pos) || IsTopLineFloatingPoint(v0.pos, v1.pos) ? AllOneLanes() : zeroLanes;
+			Lanes onEdge12Lanes = IsLeftLineFloatingPoint(v1.pos, v2.pos) || IsTopLineFloatingPoint(v1.pos, v2.pos) ? AllOneLanes() : zeroLanes;
+			Lanes onEdge20Lanes = IsLeftLineFloatingPoint(v2.pos, v0.pos) || IsTopLineFloatingPoint(v2.pos, v0.pos) ? AllOneLanes() : zeroLanes;
+
+			// 1/w = bary12 / v0.w + bary20 / v1.w + bary01 / v2.w
+			//		= edge12 * (1 / (triSizeMul2 * v0.w)) + ...
+			Lanes invW0Lanes = SetLanes(1.0f / (mTriSizeMul2 * v0.pos.w));
+			Lanes invW1Lanes = SetLanes(1.0f / (mTriSizeMul2 * v1.pos.w));
+			Lanes invW2Lanes = SetLanes(1.0f / (mTriSizeMul2 * v2.pos.w));
+			Lanes oneLanes = SetLanes(1.0f);
+
+			Lanes maxXLanes = SetLanes(mMaxX);
+			Lanes laneOffsets = LaneOffsetLanes();
+			for (float y = startY; y <= mMaxY; y += 1.0f) {
+				Vec4 rowStartPos(startX, y, 0.0f, 0.0f);
+				double xEdge01 = EdgeFunctionFloatingPoint(rowStartPos, v0.pos, v1.pos);
+				double xEdge12 = EdgeFunctionFloatingPoint(rowStartPos, v1.pos, v2.pos);
+				double xEdge20 = EdgeFunctionFloatingPoint(rowStartPos, v2.pos, v0.pos);
+
+				for (float x = startX;
+					x <= mMaxX;
+					x += static_cast<float>(LANE_NUM),
+					xEdge01 += stepEdge01,
+					xEdge12 += stepEdge12,
+					xEdge20 += stepEdge20)
+				{
+					Lanes xLanes = AddLanes(SetLanes(x), laneOffsets);
+					Lanes edge01Lanes = EdgeLanes(xEdge01, edge01Offsets);
+					Lanes edge12Lanes = EdgeLanes(xEdge12, edge12Offsets);
+					Lanes edge20Lanes = EdgeLanes(xEdge20, edge20Offsets);
 
-				if (edge12 == DF::ZERO
-					&& !IsLeftLineFloatingPoint(v1.pos, v2.pos)
-					&& !IsTopLineFloatingPoint(v1.pos, v2.pos)) {
-					continue;
+					// coverage mask : edge < 0, or edge == 0 on left, top line. and in bbox
+					Lanes coverLanes = CmpLessEqualLanes(xLanes, maxXLanes);
+					coverLanes = AndLanes(coverLanes, OrLanes(CmpLessLanes(edge01Lanes, zeroLanes), AndLanes(CmpEqualLanes(edge01Lanes, zeroLanes), onEdge01Lanes)));
+					coverLanes = AndLanes(coverLanes, OrLanes(CmpLessLanes(edge12Lanes, zeroLanes), AndLanes(CmpEqualLanes(edge12Lanes, zeroLanes), onEdge12Lanes)));
+					coverLanes = AndLanes(coverLanes, OrLanes(CmpLessLanes(edge20Lanes, zeroLanes), AndLanes(CmpEqualLanes(edge20Lanes, zeroLanes), onEdge20Lanes)));
+					uint32_t coverMask = MaskLanes(coverLanes);
+					if (coverMask == 0) {
+						continue;
+					}
+
+					// interpolate 1/w of all lanes
+					Lanes invWLanes = AddLanes(AddLanes(
+						MulLanes(edge12Lanes, invW0Lanes),
+						MulLanes(edge20Lanes, invW1Lanes)),
+						MulLanes(edge01Lanes, invW2Lanes));
+					Lanes depthLanes = DivLanes(oneLanes, invWLanes);
+
+					alignas(32) float invWs[LANE_NUM];
+					alignas(32) float depths[LANE_NUM];
+					StoreLanes(invWs, invWLanes);
+					StoreLanes(depths, depthLanes);
+
+					// add covered pixels
+					while (coverMask != 0) {
+						uint32_t lane = LowestBitIndex(coverMask);
+						coverMask &= coverMask - 1;
+
+						Pixel pixel;
+						pixel.pos = Vec4(x + lane, y, depths[lane], invWs[lane]);
+						mVaryingPlanes.Interpolate(pixel.varyings, pixel.pos.x, pixel.pos.y, pixel.pos.z);
+						pixel.materialID = mMaterialID;
+						pixels->Add(pixel);
+					}
 				}
+			}
+		}
+		else if constexpr (TYPE == RasterizationType::Partition) {
+			// rasterize bunch of pixels starts with 8*8 pixels
+			double yEdge01 = EdgeFunctionFloatingPoint(startPos, v0.pos, v1.pos);
+			double yEdge12 = EdgeFunctionFloatingPoint(startPos, v1.pos, v2.pos);
+			double yEdge20 = EdgeFunctionFloatingPoint(startPos, v2.pos, v0.pos);
+			for (float y = startY; y <= mMaxY; y += 8.0f) {
 
-				if (edge20 == DF::ZERO
-					&& !IsLeftLineFloatingPoint(v2.pos, v0.pos)
-					&& !IsTopLineFloatingPoint(v2.pos, v0.pos)) {
-					continue;
+				double xEdge01 = yEdge01;
+				double xEdge12 = yEdge12;
+				double xEdge20 = yEdge20;
+				for (float x = startX; x <= mMaxX; x += 8.0f) {
+					RasterizePartFloatingPoint(pixels, v0.pos, v1.pos, v2.pos, x, y, 3, xEdge01, xEdge12, xEdge20);
+
+					xEdge01 += mDxEdge01s[3];
+					xEdge12 += mDxEdge12s[3];
+					xEdge20 += mDxEdge20s[3];
 				}
 
-				float bary01 = edge01 / triSizeMul2;
-				float bary12 = edge12 / triSizeMul2;
-				float bary20 = edge20 / triSizeMul2;
-
-				Vec4 pos = Vec4::ZERO;
-				pos.x = x;
-				pos.y = y;
-				pos.w = bary12 / v0.pos.w
-					+ bary20 / v1.pos.w
-					+ bary01 / v2.pos.w;
-				pos.z = 1.0f / pos.w;
-
-				Pixel pixel;
-				pixel.pos = pos;
-				pixels->Add(pixel);
+				yEdge01 += mDyEdge01s[3];
+				yEdge12 += mDyEdge12s[3];
+				yEdge20 += mDyEdge20s[3];
 			}
 		}
+		else if constexpr (TYPE == RasterizationType::Advanced) {
+			// step edge values by dx, dy without evaluating edge function on each pixel
+			double yEdge01 = EdgeFunctionFloatingPoint(startPos, v0.pos, v1.pos);
+			double yEdge12 = EdgeFunctionFloatingPoint(startPos, v1.pos, v2.pos);
+			double yEdge20 = EdgeFunctionFloatingPoint(startPos, v2.pos, v0.pos);
+			for (float y = startY;
+				y <= mMaxY;
+				y += 1.0f,
+				yEdge01 += mDyEdge01s[0],
+				yEdge12 += mDyEdge12s[0],
+				yEdge20 += mDyEdge20s[0])
+			{
+				double xEdge01 = yEdge01;
+				double xEdge12 = yEdge12;
+				double xEdge20 = yEdge20;
+				for (float x = startX;
+					x <= mMaxX;
+					x += 1.0f,
+					xEdge01 += mDxEdge01s[0],
+					xEdge12 += mDxEdge12s[0],
+					xEdge20 += mDxEdge20s[0])
+				{
+					AddPixelIsInTriangleFloatingPoint(pixels, v0.pos, v1.pos, v2.pos, x, y, xEdge01, xEdge12, xEdge20);
+				}
+			}
+		}
+	}
+}
+
+template<RasterizationType TYPE>
+void RasterizeFloating<TYPE>::RasterizePartFloatingPoint(
+	PixelOutput* pixels,
+	const Vec4& v0Pos,
+	const Vec4& v1Pos,
+	const Vec4& v2Pos,
+	float leftX,
+	float topY,
+	uint8_t pixelLengthLog2,
+	double edge01,
+	double edge12,
+	double edge20)
+{
+	// pixel length = 1
+	if (pixelLengthLog2 == 0) {
+		AddPixelIsInTriangleFloatingPoint(pixels, v0Pos, v1Pos, v2Pos, leftX, topY, edge01, edge12, edge20);
+		return;
+	}
+
+	// edge values of four corners
+	double rightTopEdge01 = edge01 + (mDxEdge01s[pixelLengthLog2] - mDxEdge01s[0]);
+	double rightTopEdge12 = edge12 + (mDxEdge12s[pixelLengthLog2] - mDxEdge12s[0]);
+	double rightTopEdge20 = edge20 + (mDxEdge20s[pixelLengthLog2] - mDxEdge20s[0]);
+
+	double leftBottomEdge01 = edge01 + (mDyEdge01s[pixelLengthLog2] - mDyEdge01s[0]);
+	double leftBottomEdge12 = edge12 + (mDyEdge12s[pixelLengthLog2] - mDyEdge12s[0]);
+	double leftBottomEdge20 = edge20 + (mDyEdge20s[pixelLengthLog2] - mDyEdge20s[0]);
+
+	double rightBottomEdge01 = rightTopEdge01 + (mDyEdge01s[pixelLengthLog2] - mDyEdge01s[0]);
+	double rightBottomEdge12 = rightTopEdge12 + (mDyEdge12s[pixelLengthLog2] - mDyEdge12s[0]);
+	double rightBottomEdge20 = rightTopEdge20 + (mDyEdge20s[pixelLengthLog2] - mDyEdge20s[0]);
+
+	// edge function is linear, so block is out of triangle when four corners are out of same edge
+	bool isOutTriangle = (edge01 > 0.0f && rightTopEdge01 > 0.0f && leftBottomEdge01 > 0.0f && rightBottomEdge01 > 0.0f)
+		|| (edge12 > 0.0f && rightTopEdge12 > 0.0f && leftBottomEdge12 > 0.0f && rightBottomEdge12 > 0.0f)
+		|| (edge20 > 0.0f && rightTopEdge20 > 0.0f && leftBottomEdge20 > 0.0f && rightBottomEdge20 > 0.0f);
+	if (isOutTriangle) {
+		return;
+	}
+
+	// top level block is hidden by pixels drawn already
+	if (pixelLengthLog2 == 3) {
+		int32_t blockX = static_cast<int32_t>(floor(leftX));
+		int32_t blockY = static_cast<int32_t>(floor(topY));
+		if (pixels->IsOccluded(blockX, blockY, blockX + 7, blockY + 7, mMinDepth)) {
+			return;
+		}
+	}
 
-#elif RATSERIZATION_TYPE == PARTITION_RASTERIZATION
-#elif RASTERIZATION_TYPE == ADVANCED_RASTERIZATION
-#endif
+	float rightX = leftX + (1 << pixelLengthLog2) - 1;
+	float bottomY = topY + (1 << pixelLengthLog2) - 1;
+
+	bool isOutBBox = leftX < mMinX
+		|| rightX > mMaxX
+		|| topY < mMinY
+		|| bottomY > mMaxY;
+
+	// for not thinking top-left rule in 4*4, 8*8 pixel blocks in triangle,
+	// select only pixel blocks in triangle and not on triangle sides.
+	bool isOutOrOnTriangle = edge01 >= 0.0f
+		|| edge12 >= 0.0f
+		|| edge20 >= 0.0f
+		|| rightTopEdge01 >= 0.0f
+		|| rightTopEdge12 >= 0.0f
+		|| rightTopEdge20 >= 0.0f
+		|| leftBottomEdge01 >= 0.0f
+		|| leftBottomEdge12 >= 0.0f
+		|| leftBottomEdge20 >= 0.0f
+		|| rightBottomEdge01 >= 0.0f
+		|| rightBottomEdge12 >= 0.0f
+		|| rightBottomEdge20 >= 0.0f;
 
+	if (isOutBBox || isOutOrOnTriangle) {
+		uint8_t finePixelLengthLog2 = pixelLengthLog2 - 1;
+		float finePixelLength = static_cast<float>(1 << finePixelLengthLog2);
+
+		RasterizePartFloatingPoint(pixels, v0Pos, v1Pos, v2Pos, leftX, topY, finePixelLengthLog2,
+			edge01, edge12, edge20);
+		RasterizePartFloatingPoint(pixels, v0Pos, v1Pos, v2Pos, leftX + finePixelLength, topY, finePixelLengthLog2,
+			edge01 + mDxEdge01s[finePixelLengthLog2],
+			edge12 + mDxEdge12s[finePixelLengthLog2],
+			edge20 + mDxEdge20s[finePixelLengthLog2]);
+		RasterizePartFloatingPoint(pixels, v0Pos, v1Pos, v2Pos, leftX, topY + finePixelLength, finePixelLengthLog2,
+			edge01 + mDyEdge01s[finePixelLengthLog2],
+			edge12 + mDyEdge12s[finePixelLengthLog2],
+			edge20 + mDyEdge20s[finePixelLengthLog2]);
+		RasterizePartFloatingPoint(pixels, v0Pos, v1Pos, v2Pos, leftX + finePixelLength, topY + finePixelLength, finePixelLengthLog2,
+			edge01 + mDxEdge01s[finePixelLengthLog2] + mDyEdge01s[finePixelLengthLog2],
+			edge12 + mDxEdge12s[finePixelLengthLog2] + mDyEdge12s[finePixelLengthLog2],
+			edge20 + mDxEdge20s[finePixelLengthLog2] + mDyEdge20s[finePixelLengthLog2]);
+		return;
+	}
+
+	// add all pixels in block
+	double yEdge01 = edge01;
+	double yEdge12 = edge12;
+	double yEdge20 = edge20;
+	uint8_t pixelLength = 1 << pixelLengthLog2;
+	for (uint8_t yIdx = 0; yIdx < pixelLength; yIdx++) {
+
+		double xEdge01 = yEdge01;
+		double xEdge12 = yEdge12;
+		double xEdge20 = yEdge20;
+		for (uint8_t xIdx = 0; xIdx < pixelLength; xIdx++) {
+			Pixel pixel;
+			pixel.pos = InterpolatePosFloatingPoint(leftX + xIdx, topY + yIdx, v0Pos, v1Pos, v2Pos, xEdge01, xEdge12, xEdge20);
+			mVaryingPlanes.Interpolate(pixel.varyings, pixel.pos.x, pixel.pos.y, pixel.pos.z);
+			pixel.materialID = mMaterialID;
+			pixels->Add(pixel);
+
+			xEdge01 += mDxEdge01s[0];
+			xEdge12 += mDxEdge12s[0];
+			xEdge20 += mDxEdge20s[0];
+		}
+
+		yEdge01 += mDyEdge01s[0];
+		yEdge12 += mDyEdge12s[0];
+		yEdge20 += mDyEdge20s[0];
 	}
 }
 
-inline bool RasterizeFloating::IsLeftLineFloatingPoint(const Vec4& prePos, const Vec4& nextPos) const
+template<RasterizationType TYPE>
+inline void RasterizeFloating<TYPE>::AddPixelIsInTriangleFloatingPoint(PixelOutput* pixels, const Vec4& v0Pos, const Vec4& v1Pos, const Vec4& v2Pos, float x, float y, double edge01, double edge12, double edge20)
+{
+	// out bbox
+	bool isOutBBox = x < mMinX
+		|| x > mMaxX
+		|| y < mMinY
+		|| y > mMaxY;
+	if (isOutBBox) {
+		return;
+	}
+
+	// not in triangle
+	bool isSelect = IsSelectPixelFloatingPoint(v0Pos, v1Pos, v2Pos, edge01, edge12, edge20);
+	if (isSelect == false) {
+		return;
+	}
+
+	Pixel pixel;
+	pixel.pos = InterpolatePosFloatingPoint(x, y, v0Pos, v1Pos, v2Pos, edge01, edge12, edge20);
+	mVaryingPlanes.Interpolate(pixel.varyings, pixel.pos.x, pixel.pos.y, pixel.pos.z);
+	pixel.materialID = mMaterialID;
+	pixels->Add(pixel);
+}
+
+template<RasterizationType TYPE>
+inline bool RasterizeFloating<TYPE>::IsSelectPixelFloatingPoint(const Vec4& v0Pos, const Vec4& v1Pos, const Vec4& v2Pos, double edge01, double edge12, double edge20) const
+{
+	if (edge01 > 0.0f
+		|| edge12 > 0.0f
+		|| edge20 > 0.0f) {
+		return false;
+	}
+
+	if (edge01 == 0.0f
+		&& !IsLeftLineFloatingPoint(v0Pos, v1Pos)
+		&& !IsTopLineFloatingPoint(v0Pos, v1Pos)) {
+		return false;
+	}
+
+	if (edge12 == 0.0f
+		&& !IsLeftLineFloatingPoint(v1Pos, v2Pos)
+		&& !IsTopLineFloatingPoint(v1Pos, v2Pos)) {
+		return false;
+	}
+
+	if (edge20 == 0.0f
+		&& !IsLeftLineFloatingPoint(v2Pos, v0Pos)
+		&& !IsTopLineFloatingPoint(v2Pos, v0Pos)) {
+		return false;
+	}
+
+	return true;
+}
+
+template<RasterizationType TYPE>
+inline bool RasterizeFloating<TYPE>::IsLeftLineFloatingPoint(const Vec4& prePos, const Vec4& nextPos) const
 {
 	return (nextPos - prePos).y < 0;
 }
 
-inline bool RasterizeFloating::IsTopLineFloatingPoint(const Vec4& prePos, const Vec4& nextPos) const
+template<RasterizationType TYPE>
+inline bool RasterizeFloating<TYPE>::IsTopLineFloatingPoint(const Vec4& prePos, const Vec4& nextPos) const
 {
 	return ((nextPos - prePos).y == 0) && ((nextPos - prePos).x > 0);
 }
 
+template<RasterizationType TYPE>
+inline Vec4 RasterizeFloating<TYPE>::InterpolatePosFloatingPoint(
+	float x,
+	float y,
+	const Vec4& v0Pos,
+	const Vec4& v1Pos,
+	const Vec4& v2Pos,
+	double edge01,
+	double edge12,
+	double edge20) const
+{
+	float bary01 = static_cast<float>(edge01) / mTriSizeMul2;
+	float bary12 = static_cast<float>(edge12) / mTriSizeMul2;
+	float bary20 = static_cast<float>(edge20) / mTriSizeMul2;
+
+	Vec4 pos = Vec4::ZERO;
+	pos.x = x;
+	pos.y = y;
+	pos.w = bary12 / v0Pos.w
+		+ bary20 / v1Pos.w
+		+ bary01 / v2Pos.w;
+	pos.z = 1.0f / pos.w;
+
+	return pos;
+}
+
+template class RasterizeFloating<RasterizationType::Normal>;
+template class RasterizeFloating<RasterizationType::Partition>;
+template class RasterizeFloating<RasterizationType::Advanced>;
\ No newline at end of file
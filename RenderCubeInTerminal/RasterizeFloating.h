@@ -1,90 +1,106 @@
 #pragma once
 #include "IRasterizable.h"
 #include "Primitive.h"
+#include "VaryingPlanes.h"
 
+template<RasterizationType TYPE>
 class RasterizeFloating : public IRasterizable {
 public:
-	void Rasterize(List* pixels, const List* floatingVertices, const List* indices) override;	
+	void Rasterize(PixelOutput* pixels, const List* floatingVertices, const List* indices, const List* materialIDs, const ScissorRect& scissor,
+		uint32_t varyingNum) override;	
 	virtual ~RasterizeFloating() override {}
 
 private:
-	inline DF EdgeFunctionFixedPoint(const FixedVec4& pixelPos, const FixedVec4& v0Pos, const FixedVec4& v1Pos) const
-	{
-		FixedVec4 pMinusV0 = pixelPos - v0Pos;
-		FixedVec4 v1MinusV0 = v1Pos - v0Pos;
-
-		DF v0PX = pMinusV0.x.ToDoubleFixedPoint();
-		DF v0V1Y = v1MinusV0.y.ToDoubleFixedPoint();
-		DF v0PY = pMinusV0.y.ToDoubleFixedPoint();
-		DF v0V1X = v1MinusV0.x.ToDoubleFixedPoint();
+	// positions are snapped to sub pixel grid and edge values of them are set up, stepped in double.
+	//		they are exact while |x|, |y| < 2^(24 - SUB_PIXEL_BITS) whatever size of triangle is,
+	//		float keeps snapped positions and double keeps products of their differences
+	static constexpr int32_t SUB_PIXEL_BITS = 4;
+	static constexpr float SUB_PIXEL_SCALE = static_cast<float>(1 << SUB_PIXEL_BITS);
 
-		return v0PX * v0V1Y - v0PY * v0V1X;
+	inline void SnapToSubPixel(Vec4& pos) const
+	{
+		pos.x = roundf(pos.x * SUB_PIXEL_SCALE) / SUB_PIXEL_SCALE;
+		pos.y = roundf(pos.y * SUB_PIXEL_SCALE) / SUB_PIXEL_SCALE;
 	}
 
-	inline float EdgeFunctionFloatingPoint(const Vec4& pixelPos, const Vec4& v0Pos, const Vec4 v1Pos) const
+	inline double EdgeFunctionFloatingPoint(const Vec4& pixelPos, const Vec4& v0Pos, const Vec4 v1Pos) const
 	{
-		Vec4 pMinusV0 = pixelPos - v0Pos;
-		Vec4 v1MinusV0 = v1Pos - v0Pos;
+		double pMinusV0X = static_cast<double>(pixelPos.x) - v0Pos.x;
+		double pMinusV0Y = static_cast<double>(pixelPos.y) - v0Pos.y;
+		double v1MinusV0X = static_cast<double>(v1Pos.x) - v0Pos.x;
+		double v1MinusV0Y = static_cast<double>(v1Pos.y) - v0Pos.y;
 
-		return pMinusV0.x * v1MinusV0.y - pMinusV0.y * v1MinusV0.x;
+		return pMinusV0X * v1MinusV0Y - pMinusV0Y * v1MinusV0X;
 	}
 
 	void RasterizePartFloatingPoint(
+		PixelOutput* pixels,
 		const Vec4& v0Pos,
 		const Vec4& v1Pos,
 		const Vec4& v2Pos,
 		float leftX,
 		float topY,
 		uint8_t pixelLengthLog2,
-		float edge01,
-		float edge12,
-		float edge20);
+		double edge01,
+		double edge12,
+		double edge20);
 
 
 	inline void AddPixelIsInTriangleFloatingPoint(
+		PixelOutput* pixels,
 		const Vec4& v0Pos,
 		const Vec4& v1Pos,
 		const Vec4& v2Pos,
 		float x,
 		float y,
-		float edge01,
-		float edge12,
-		float edge23
+		double edge01,
+		double edge12,
+		double edge20
 	);
 
 	inline bool IsSelectPixelFloatingPoint(
 		const Vec4& v0Pos,
 		const Vec4& v1Pos,
 		const Vec4& v2Pos,
-		float x,
-		float y,
-		float edge01,
-		float edge12,
-		float edge20
-	);
+		double edge01,
+		double edge12,
+		double edge20
+	) const;
 
 	inline bool IsLeftLineFloatingPoint(const Vec4& prePos, const Vec4& nextPos) const;
 	inline bool IsTopLineFloatingPoint(const Vec4& prePos, const Vec4& nextPos) const;
 
+	inline Vec4 InterpolatePosFloatingPoint(
+		float x,
+		float y,
+		const Vec4& v0Pos,
+		const Vec4& v1Pos,
+		const Vec4& v2Pos,
+		double edge01,
+		double edge12,
+		double edge20) const;
 
 private:
 	// dxEdgeFunctionValue, 2 * dxEdgeFunctionValue, 4 * dxEdgeFunctionValue, 8 * dxEdgeFunctionValue
-	DF mDxEdge01s[4];
-	DF mDxEdge12s[4];
-	DF mDxEdge20s[4];
+	double mDxEdge01s[4];
+	double mDxEdge12s[4];
+	double mDxEdge20s[4];
 	// dyEdgeFunctionValue, 2 * dyEdgeFunctionValue, 4 * dyEdgeFunctionValue, 8 * dyEdgeFunctionValue
-	DF mDyEdge01s[4];
-	DF mDyEdge12s[4];
-	DF mDyEdge20s[4];
+	double mDyEdge01s[4];
+	double mDyEdge12s[4];
+	double mDyEdge20s[4];
 
-	DF mTriSizeMul2;
-
-	// bbox covers triangle
-	FP mMinX = FP::ZERO;
-	FP mMaxX = FP::ZERO;
-	FP mMinY = FP::ZERO;
-	FP mMaxY = FP::ZERO;
+	float mTriSizeMul2 = 0.0f;
 
+	// depth of nearest vertex
+	float mMinDepth = 0.0f;
 
+	VaryingPlanes mVaryingPlanes;
+	uint32_t mMaterialID = 0;
 
+	// bbox covers triangle
+	float mMinX = 0.0f;
+	float mMaxX = 0.0f;
+	float mMinY = 0.0f;
+	float mMaxY = 0.0f;
 };
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "RasterizeScanline.h"
+#include <cassert>
+
+template<typename FORMAT>
+void RasterizeScanline<FORMAT>::Rasterize(PixelOutput* pixels, const List* fixedVertices, const TriangleSetupBase& triangleSetup, const List* triangles,
+	const ScissorRect& scissor, uint32_t varyingNum)
+{
+	// setup is made in format of this rasterizer (see RasterizerRegistry::CreateTriangleSetup)
+	assert(dynamic_cast<const TriangleSetup<FORMAT>*>(&triangleSetup) != nullptr);
+	const TriangleSetup<FORMAT>& setup = static_cast<const TriangleSetup<FORMAT>&>(triangleSetup);
+
+	uint32_t triangleNum = triangles != nullptr ? static_cast<uint32_t>(triangles->GetSize()) : setup.GetTriangleNum();
+	for (uint32_t i = 0; i < triangleNum; i++) {
+		RasterizeTriangle(pixels, fixedVertices, setup, triangles != nullptr ? triangles->At<uint32_t>(i) : i, scissor, varyingNum);
+	}
+}
+
+template<typename FORMAT>
+void RasterizeScanline<FORMAT>::RasterizeTriangle(PixelOutput* pixels, const List* fixedVertices, const TriangleSetup<FORMAT>& setup, uint32_t triangle,
+	const ScissorRect& scissor, uint32_t varyingNum)
+{
+	const static FP halfOne = FP(0.5f);
+
+	// setup is shared by tiles, so its bbox is cut by scissor of tile
+	int32_t minX, minY, maxX, maxY;
+	if (setup.GetBBoxInScissor(triangle, scissor, &minX, &minY, &maxX, &maxY) == false) {
+		return;
+	}
+	uint32_t materialID = setup.GetMaterialID(triangle);
+
+	// depth of pixel is interpolated between depths of vertices, so it is never nearer than nearest vertex
+	mVertexWs[0] = setup.GetVertexW(0, triangle);
+	mVertexWs[1] = setup.GetVertexW(1, triangle);
+	mVertexWs[2] = setup.GetVertexW(2, triangle);
+	float minDepth = std::min(mVertexWs[0], std::min(mVertexWs[1], mVertexWs[2]));
+	if (pixels->IsOccluded(minX, minY, maxX, maxY, minDepth)) {
+		return;
+	}
+
+	// varyings are interpolated in floating point
+	mVaryingPlanes.varyingNum = 0;
+	if (varyingNum > 0) {
+		const FixedVertex& v0 = fixedVertices->At<FixedVertex>(setup.GetVertexIndex(0, triangle));
+		const FixedVertex& v1 = fixedVertices->At<FixedVertex>(setup.GetVertexIndex(1, triangle));
+		const FixedVertex& v2 = fixedVertices->At<FixedVertex>(setup.GetVertexIndex(2, triangle));
+		mVaryingPlanes.Setup(varyingNum, v0.pos.ToVec4(), v0.varyings, v1.pos.ToVec4(), v1.varyings, v2.pos.ToVec4(), v2.varyings);
+	}
+
+	// 1 / w is linear in viewport space.
+	// barycentric coordinate of vertex is edge value of opposite edge * invTriSizeMul2
+	double invTriSizeMul2 = setup.GetInvTriSizeMul2(triangle);
+	const float* oppositeWs[EDGE_NUM] = { &mVertexWs[2], &mVertexWs[0], &mVertexWs[1] };
+	double invWEdges[EDGE_NUM];
+	double invWXStep = 0.0;
+
+	FP leftX = FP(static_cast<float>(minX)) + halfOne;
+	FP topY = FP(static_cast<float>(minY)) + halfOne;
+	DF rowEdges[EDGE_NUM];
+	DF xSteps[EDGE_NUM];
+	DF ySteps[EDGE_NUM];
+	for (uint8_t e = 0; e < EDGE_NUM; e++) {
+		rowEdges[e] = setup.EvaluateEdge(e, triangle, leftX, topY);
+		xSteps[e] = setup.GetEdgeX(e, triangle);
+		ySteps[e] = setup.GetEdgeY(e, triangle);
+
+		invWEdges[e] = invTriSizeMul2 / *oppositeWs[e];
+		invWXStep += xSteps[e].ToDouble() * invWEdges[e];
+	}
+
+	int64_t width = static_cast<int64_t>(maxX) - minX + 1;
+	for (int32_t y = minY; y <= maxY; y++) {
+		int64_t begin;
+		int64_t end;
+		CalculateSpan(rowEdges, xSteps, width, &begin, &end);
+
+		// span is hidden by pixels drawn already
+		if (begin < end && pixels->IsOccluded(minX + static_cast<int32_t>(begin), y, minX + static_cast<int32_t>(end) - 1, y, minDepth)) {
+			begin = end;
+		}
+
+		// 1 / w of first pixel of span, then stepped by x
+		double invW = 0.0;
+		for (uint8_t e = 0; e < EDGE_NUM; e++) {
+			invW += (rowEdges[e].ToDouble() + begin * xSteps[e].ToDouble()) * invWEdges[e];
+		}
+
+		// pixels without varyings are restored from 1 / w plane, so whole span is added at once
+		if (mVaryingPlanes.varyingNum == 0) {
+			if (begin < end) {
+				Span span;
+				span.y = y;
+				span.leftX = minX + static_cast<int32_t>(begin);
+				span.length = static_cast<uint32_t>(end - begin);
+				span.invW = static_cast<float>(invW);
+				span.invWDx = static_cast<float>(invWXStep);
+				span.materialID = materialID;
+				pixels->AddSpan(span);
+			}
+		}
+		else {
+			Pixel pixel;
+			pixel.pos.y = static_cast<float>(y) + 0.5f;
+			pixel.materialID = materialID;
+			for (int64_t x = minX + begin; x < minX + end; x++, invW += invWXStep) {
+				pixel.pos.x = static_cast<float>(x) + 0.5f;
+				pixel.pos.w = static_cast<float>(invW);
+				pixel.pos.z = 1.0f / pixel.pos.w;
+				mVaryingPlanes.Interpolate(pixel.varyings, pixel.pos.x, pixel.pos.y, pixel.pos.z);
+
+				pixels->Add(pixel);
+			}
+		}
+
+		for (uint8_t e = 0; e < EDGE_NUM; e++) {
+			rowEdges[e] += ySteps[e];
+		}
+	}
+}
+
+template<typename FORMAT>
+inline void RasterizeScanline<FORMAT>::CalculateSpan(const DF* rowEdges, const DF* xSteps, int64_t width, int64_t* pBegin, int64_t* pEnd) const
+{
+	// pixel i of row is selected when edge + i * step < 0 for all edges.
+	// edge values are multiples of raw unit, so span is solved exactly in raw integers
+	int64_t begin = 0;
+	int64_t end = width;
+	for (uint8_t e = 0; e < EDGE_NUM; e++) {
+		int64_t edge = rowEdges[e].raw;
+		int64_t step = xSteps[e].raw;
+
+		// edge value increases by x, pixels after some pixel are out
+		if (step > 0) {
+			int64_t edgeEnd = edge < 0 ? (-edge + step - 1) / step : 0;
+			end = std::min(end, edgeEnd);
+		}
+		// edge value decreases by x, pixels before some pixel are out
+		else if (step < 0) {
+			int64_t edgeBegin = edge < 0 ? 0 : edge / -step + 1;
+			begin = std::max(begin, edgeBegin);
+		}
+		// edge is horizontal, all or no pixels of row are out
+		else if (edge >= 0) {
+			end = 0;
+		}
+	}
+
+	*pBegin = begin;
+	*pEnd = std::max(begin, end);
+}
+
+template class RasterizeScanline<WideFixedPointFormat>;
+template class RasterizeScanline<NarrowFixedPointFormat>;
\ No newline at end of file
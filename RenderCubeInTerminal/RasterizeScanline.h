@@ -0,0 +1,41 @@
+#pragma once
+#include "IRasterizable.h"
+#include "Primitive.h"
+#include "VaryingPlanes.h"
+#include "TriangleSetup.h"
+
+/// <summary>
+/// Fixed point rasterizer which walks rows of triangle.
+/// Each row is clipped by edges to a span of covered pixels, so pixels out of triangle in bbox are never visited.
+/// It is for large triangles, where bbox traversal tests up to half of bbox for nothing.
+/// </summary>
+template<typename FORMAT>
+class RasterizeScanline : public ISetupRasterizable {
+public:
+	typedef typename FORMAT::FP FP;
+	typedef typename FORMAT::DF DF;
+
+private:
+	// edge 01, 12, 20
+	static constexpr uint8_t EDGE_NUM = TriangleSetup<FORMAT>::EDGE_NUM;
+
+public:
+	RasterizeScanline() {}
+	virtual void Rasterize(PixelOutput* pixels, const List* fixedVertices, const TriangleSetupBase& setup, const List* triangles, const ScissorRect& scissor,
+		uint32_t varyingNum) override;
+	virtual ~RasterizeScanline() override {}
+
+private:
+	// rows of triangle in scissor
+	void RasterizeTriangle(PixelOutput* pixels, const List* fixedVertices, const TriangleSetup<FORMAT>& setup, uint32_t triangle,
+		const ScissorRect& scissor, uint32_t varyingNum);
+
+	// pixels [begin, end) from left of row are covered.
+	// edge values are of left pixel of row and steps are edge value differences by 1 x
+	inline void CalculateSpan(const DF* rowEdges, const DF* xSteps, int64_t width, int64_t* pBegin, int64_t* pEnd) const;
+
+private:
+	// w of vertices. depth is interpolated in floating point
+	float mVertexWs[3];
+	VaryingPlanes mVaryingPlanes;
+};
\ No newline at end of file
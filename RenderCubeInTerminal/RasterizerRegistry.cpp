@@ -0,0 +1,116 @@
+#include "RasterizerRegistry.h"
+#include "RasterizeFixed.h"
+#include "RasterizeFloating.h"
+#include "RasterizeScanline.h"
+#include <cassert>
+#include <cstring>
+
+template<RasterizationType TYPE>
+static IRasterizable* CreateFloatingRasterizer()
+{
+	return new RasterizeFloating<TYPE>;
+}
+
+template<RasterizationType TYPE>
+static ISetupRasterizable* CreateFixedRasterizer(FixedPointPrecision precision)
+{
+	if (precision == FixedPointPrecision::Narrow) {
+		return new RasterizeFixed<TYPE, NarrowFixedPointFormat>;
+	}
+
+	return new RasterizeFixed<TYPE, WideFixedPointFormat>;
+}
+
+static ISetupRasterizable* CreateScanlineRasterizer(FixedPointPrecision precision)
+{
+	if (precision == FixedPointPrecision::Narrow) {
+		return new RasterizeScanline<NarrowFixedPointFormat>;
+	}
+
+	return new RasterizeScanline<WideFixedPointFormat>;
+}
+
+// same order with RasterizerEngine
+static const RasterizerRegistry::Entry ENTRIES[] = {
+	{ RasterizerEngine::FloatingNormal, "floating-normal", false, CreateFloatingRasterizer<RasterizationType::Normal>, nullptr },
+	{ RasterizerEngine::FloatingPartition, "floating-partition", false, CreateFloatingRasterizer<RasterizationType::Partition>, nullptr },
+	{ RasterizerEngine::FloatingAdvanced, "floating-advanced", false, CreateFloatingRasterizer<RasterizationType::Advanced>, nullptr },
+	{ RasterizerEngine::FixedNormal, "fixed-normal", true, nullptr, CreateFixedRasterizer<RasterizationType::Normal> },
+	{ RasterizerEngine::FixedPartition, "fixed-partition", true, nullptr, CreateFixedRasterizer<RasterizationType::Partition> },
+	{ RasterizerEngine::FixedAdvanced, "fixed-advanced", true, nullptr, CreateFixedRasterizer<RasterizationType::Advanced> },
+	{ RasterizerEngine::FixedScanline, "fixed-scanline", true, nullptr, CreateScanlineRasterizer },
+};
+static_assert(sizeof(ENTRIES) / sizeof(ENTRIES[0]) == static_cast<size_t>(RasterizerEngine::Length), "every engine must be registered");
+
+const RasterizerRegistry::Entry& RasterizerRegistry::GetEntry(RasterizerEngine engine)
+{
+	uint32_t index = static_cast<uint32_t>(engine);
+	assert(index < GetEntryNum());
+	assert(ENTRIES[index].engine == engine);
+
+	return ENTRIES[index];
+}
+
+const RasterizerRegistry::Entry* RasterizerRegistry::FindEntry(const char* name)
+{
+	for (uint32_t i = 0; i < GetEntryNum(); i++) {
+		if (strcmp(ENTRIES[i].name, name) == 0) {
+			return &ENTRIES[i];
+		}
+	}
+
+	return nullptr;
+}
+
+IRasterizable* RasterizerRegistry::CreateFloating(RasterizerEngine engine)
+{
+	const Entry& entry = GetEntry(engine);
+	assert(!entry.isFixedPoint);
+
+	return entry.createFloating();
+}
+
+ISetupRasterizable* RasterizerRegistry::CreateFixed(RasterizerEngine engine, FixedPointPrecision precision)
+{
+	const Entry& entry = GetEntry(engine);
+	assert(entry.isFixedPoint);
+
+	return entry.createFixed(precision);
+}
+
+TriangleSetupBase* RasterizerRegistry::CreateTriangleSetup(FixedPointPrecision precision)
+{
+	if (precision == FixedPointPrecision::Narrow) {
+		return new TriangleSetup<NarrowFixedPointFormat>;
+	}
+
+	return new TriangleSetup<WideFixedPointFormat>;
+}
+
+FixedPointPrecision RasterizerRegistry::SelectFixedPointPrecision(const ScissorRect& viewportRect)
+{
+	bool isInNarrowGuardBand = viewportRect.leftX >= NarrowFixedPointFormat::GUARD_BAND_MIN
+		&& viewportRect.topY >= NarrowFixedPointFormat::GUARD_BAND_MIN
+		&& viewportRect.rightX <= NarrowFixedPointFormat::GUARD_BAND_MAX
+		&& viewportRect.bottomY <= NarrowFixedPointFormat::GUARD_BAND_MAX;
+
+	return isInNarrowGuardBand ? FixedPointPrecision::Narrow : FixedPointPrecision::Wide;
+}
+
+bool RasterizerRegistry::GetGuardBand(RasterizerEngine engine, FixedPointPrecision precision, float* pMin, float* pMax)
+{
+	// floating point engines have no guard band, so they are clipped at viewport
+	if (!GetEntry(engine).isFixedPoint) {
+		return false;
+	}
+
+	if (precision == FixedPointPrecision::Narrow) {
+		*pMin = NarrowFixedPointFormat::GUARD_BAND_MIN;
+		*pMax = NarrowFixedPointFormat::GUARD_BAND_MAX;
+		return true;
+	}
+
+	*pMin = WideFixedPointFormat::GUARD_BAND_MIN;
+	*pMax = WideFixedPointFormat::GUARD_BAND_MAX;
+	return true;
+}
\ No newline at end of file
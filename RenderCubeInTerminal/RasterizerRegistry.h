@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+#include "IRasterizable.h"
+
+// every rasterizer compiled in binary. number representation x traversal algorithm
+enum class RasterizerEngine {
+	FloatingNormal = 0,
+	FloatingPartition,
+	FloatingAdvanced,
+	FixedNormal,
+	FixedPartition,
+	FixedAdvanced, // also tests micro triangles in groups across SIMD lanes, in narrow format
+	FixedScanline, // spans of rows, for large triangles
+	Length
+};
+
+// number format of fixed point engines. floating point engines ignore it
+enum class FixedPointPrecision {
+	Wide = 0, // WideFixedPointFormat
+	Narrow, // NarrowFixedPointFormat. only for viewport in its guard band
+	Length
+};
+
+/// <summary>
+/// Table of rasterizer engines which can be selected at runtime.
+/// </summary>
+class RasterizerRegistry {
+public:
+	struct Entry {
+		RasterizerEngine engine;
+		const char* name;
+		// fixed point engine rasterizes FixedVertex, floating point engine rasterizes Vertex
+		bool isFixedPoint;
+		// only create of its kind is not null
+		IRasterizable* (*createFloating)();
+		ISetupRasterizable* (*createFixed)(FixedPointPrecision precision);
+	};
+
+	static constexpr RasterizerEngine DEFAULT_ENGINE = RasterizerEngine::FloatingNormal;
+
+public:
+	static const Entry& GetEntry(RasterizerEngine engine);
+	// nullptr if there is no engine named name
+	static const Entry* FindEntry(const char* name);
+	static inline uint32_t GetEntryNum() {
+		return static_cast<uint32_t>(RasterizerEngine::Length);
+	}
+
+	// caller owns returned rasterizer. engine must be of the kind
+	static IRasterizable* CreateFloating(RasterizerEngine engine);
+	static ISetupRasterizable* CreateFixed(RasterizerEngine engine, FixedPointPrecision precision = FixedPointPrecision::Wide);
+	// setup of triangles which fixed point engines of precision read. caller owns returned setup
+	static TriangleSetupBase* CreateTriangleSetup(FixedPointPrecision precision);
+
+	// narrow precision when viewport is small enough. edge function values of it are stepped in 32 bits
+	static FixedPointPrecision SelectFixedPointPrecision(const ScissorRect& viewportRect);
+	// range of x, y in viewport space which engine can rasterize.
+	//		false if engine has no guard band, so x, y are clipped at viewport
+	static bool GetGuardBand(RasterizerEngine engine, FixedPointPrecision precision, float* pMin, float* pMax);
+};
\ No newline at end of file
@@ -82,12 +82,27 @@ void TestSIMD() {
 
 }
 
-int main() { 
+int main(int argc, char* argv[]) { 
     TestSIMD();
 
+    // rasterizer engine is selected by name. ex) RenderCubeInTerminal.exe fixed-partition
+    RasterizerEngine engine = RasterizerRegistry::DEFAULT_ENGINE;
+    if (argc > 1) {
+        const RasterizerRegistry::Entry* entry = RasterizerRegistry::FindEntry(argv[1]);
+        if (entry != nullptr) {
+            engine = entry->engine;
+        }
+        else {
+            cout << "unknown rasterizer engine : " << argv[1] << endl;
+            for (uint32_t i = 0; i < RasterizerRegistry::GetEntryNum(); i++) {
+                cout << "\t" << RasterizerRegistry::GetEntry(static_cast<RasterizerEngine>(i)).name << endl;
+            }
+        }
+    }
+
     // main render loop
     Renderer renderer;
-    renderer.Initialize();
+    renderer.Initialize(engine);
 
     std::chrono::steady_clock::time_point prevFrameSec = std::chrono::high_resolution_clock::now();
     while (true) {
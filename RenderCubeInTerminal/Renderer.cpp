@@ -2,10 +2,8 @@
 #include "Constants.h"
 #include "Math.h"
 
-#undef max;
 
-
-void Renderer::Initialize() {   
+void Renderer::Initialize(RasterizerEngine engine) {   
     // console
 #ifdef _WIN32
     mHFrontConsole = CreateConsoleScreenBuffer(GENERIC_READ | GENERIC_WRITE, 0, NULL, CONSOLE_TEXTMODE_BUFFER, NULL);
@@ -18,14 +16,22 @@ void Renderer::Initialize() {
 
     // rasterizer
     mRasterize = new SWRasterizer;
-    mRasterize->Initialize();
+    mRasterize->Initialize(Constants::RENDER_SCREEN_WIDTH, Constants::RENDER_SCREEN_HEIGHT, engine);
     mRasterize->SetupViewport(mViewport);
+    mAppliedViewport = mViewport;
+    mEngine = engine;
 
     // pixel shader
     mPixelShaderManager = new PixelShaderManager();
     mPixelShaderManager->Initialize(mViewport.width, mViewport.height);        
     mSimplePixelShader = new SimplePixelShader();                           
 
+    // vertex shader
+    mSimpleVertexShader = new SimpleVertexShader();
+
+    // draw commands
+    mDrawCommands = new List(sizeof(DrawCommand), RESERVED_DRAW_COMMAND_NUM);
+
     // variable
     mRotationX = 0.0f;
     mRotationY = 0.0f;
@@ -62,6 +68,16 @@ void Renderer::Terminate() {
         delete mSimplePixelShader;
         mSimplePixelShader = nullptr;
     }
+
+    if (mSimpleVertexShader != nullptr) {
+        delete mSimpleVertexShader;
+        mSimpleVertexShader = nullptr;
+    }
+
+    if (mDrawCommands != nullptr) {
+        delete mDrawCommands;
+        mDrawCommands = nullptr;
+    }
 }
 
 std::chrono::steady_clock::time_point Renderer::Frame(std::chrono::steady_clock::time_point prevFrameSec)
@@ -93,21 +109,125 @@ std::chrono::steady_clock::time_point Renderer::Frame(std::chrono::steady_clock:
         Math::Rad2Deg(mRotationY),
         Math::Rad2Deg(mRotationZ));
 
-    //      print to terminal        
-    PrintToTerminal();
-
+    //      execute draws, print to terminal
     EndScene();
 
     return frameTime;
 }
 
-void Renderer::Render(const Vertex* vertices, uint32_t vertexNum, const uint32_t* indices, uint32_t indexNum, PixelShader* pixelShader)
+void Renderer::Render(const Vertex* vertices, uint32_t vertexNum, const uint32_t* indices, uint32_t indexNum,
+    VertexShader* vertexShader, const VertexUniforms& uniforms, PixelShader* pixelShader,
+    uint32_t varyingNum, const uint32_t* materialIDs)
+{
+    DrawCommand command;
+    command.vertices = ArrayView<Vertex>(vertices, vertexNum);
+    command.indices = ArrayView<uint32_t>(indices, indexNum);
+    command.vertexShader = vertexShader;
+    command.vertexUniforms = uniforms;
+    command.pixelShader = pixelShader;
+    command.varyingNum = varyingNum;
+    command.materialIDs = materialIDs;
+    command.viewport = mViewport;
+    command.engine = mEngine;
+    command.depthKey = std::numeric_limits<float>::max();
+    //      w of clip space is row 3 of model view projection times position
+    const Mat4x4& mvp = uniforms.modelViewProjection;
+    const Vec4 clipW = vertexShader != nullptr ? Vec4(mvp.m30, mvp.m31, mvp.m32, mvp.m33) : Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    for (uint32_t i = 0; i < vertexNum; i++) {
+        float w = Vec4::Dot(clipW, vertices[i].pos);
+        command.depthKey = std::min(command.depthKey, w);
+    }
+    command.order = static_cast<uint32_t>(mDrawCommands->GetSize());
+
+    mDrawCommands->Add<DrawCommand>(command);
+}
+
+void Renderer::Render(const Vertex* vertices, uint32_t vertexNum, const uint32_t* indices, uint32_t indexNum, PixelShader* pixelShader,
+    uint32_t varyingNum, const uint32_t* materialIDs)
+{
+    Render(vertices, vertexNum, indices, indexNum, nullptr, VertexUniforms(), pixelShader, varyingNum, materialIDs);
+}
+
+void Renderer::SetViewport(const SWRasterizer::Viewport& viewport)
+{
+    mViewport = viewport;
+}
+
+void Renderer::SetRasterizerEngine(RasterizerEngine engine)
+{
+    mEngine = engine;
+}
+
+void Renderer::ExecuteDrawCommands()
+{
+    DrawCommand* commands = mDrawCommands->GetData<DrawCommand>();
+    uint64_t commandNum = mDrawCommands->GetSize();
+
+    // same state is contiguous, and draws in it are front to back
+    std::sort(commands, commands + commandNum, [](const DrawCommand& a, const DrawCommand& b) {
+        auto aViewport = std::tie(a.viewport.leftX, a.viewport.topY, a.viewport.width, a.viewport.height, a.viewport.minZ, a.viewport.maxZ);
+        auto bViewport = std::tie(b.viewport.leftX, b.viewport.topY, b.viewport.width, b.viewport.height, b.viewport.minZ, b.viewport.maxZ);
+        if (aViewport != bViewport) {
+            return aViewport < bViewport;
+        }
+        if (a.engine != b.engine) {
+            return a.engine < b.engine;
+        }
+        if (a.pixelShader != b.pixelShader) {
+            return std::less<PixelShader*>()(a.pixelShader, b.pixelShader);
+        }
+        if (a.vertexShader != b.vertexShader) {
+            return std::less<VertexShader*>()(a.vertexShader, b.vertexShader);
+        }
+        return std::tie(a.depthKey, a.order) < std::tie(b.depthKey, b.order);
+    });
+
+    // state is bound again in every scene
+#if !defined(TILED_RASTERIZATION) && !defined(FUSED_RASTERIZATION)
+    PixelShader* appliedPixelShader = nullptr;
+#endif
+    for (uint64_t i = 0; i < commandNum; i++) {
+        const DrawCommand& command = commands[i];
+
+        if (!IsSameViewport(command.viewport, mAppliedViewport)) {
+            mRasterize->SetupViewport(command.viewport);
+            mAppliedViewport = command.viewport;
+        }
+        if (command.engine != mRasterize->GetRasterizerEngine()) {
+            mRasterize->SetRasterizerEngine(command.engine);
+        }
+#if !defined(TILED_RASTERIZATION) && !defined(FUSED_RASTERIZATION)
+        if (command.pixelShader != appliedPixelShader) {
+            mPixelShaderManager->SetupPixelShader(command.pixelShader);
+            appliedPixelShader = command.pixelShader;
+        }
+#endif
+
+        ExecuteDrawCommand(command);
+    }
+
+    mDrawCommands->Reset(sizeof(DrawCommand));
+}
+
+void Renderer::ExecuteDrawCommand(const DrawCommand& command)
 {
+    // uniforms are of each draw
+    mRasterize->SetupVertexShader(command.vertexShader, command.vertexUniforms);
+
+#ifdef TILED_RASTERIZATION
+    // rasterize, pixel shader, output merger in tiles
+    mRasterize->ExecuteTiled(command.vertices, command.indices, command.pixelShader,
+        command.varyingNum, command.materialIDs);
+#elif defined(FUSED_RASTERIZATION)
+    // rasterize, pixel shader, output merger per pixel
+    mRasterize->ExecuteFused(command.vertices, command.indices, command.pixelShader,
+        reinterpret_cast<wchar_t*>(mRenderBuffer), reinterpret_cast<float*>(mZBuffer), Constants::RENDER_SCREEN_WIDTH,
+        command.varyingNum, command.materialIDs);
+#else
     // rasterize
-    mRasterize->Execute(vertices, vertexNum, indices, indexNum);
+    mRasterize->Execute(command.vertices, command.indices, command.varyingNum, command.materialIDs);
 
-    // pixel shader
-    mPixelShaderManager->SetupPixelShader(pixelShader);
+    // pixel shader, set up by ExecuteDrawCommands
     mPixelShaderManager->Execute(mRasterize);
 
     // output merger
@@ -118,18 +238,41 @@ void Renderer::Render(const Vertex* vertices, uint32_t vertexNum, const uint32_t
             outPixel.depth,
             outPixel.c);
     }
+#endif
 }
 
 
 void Renderer::BeginScene() { // start of render
     // clear buffer
     ClearBuffer();
+#ifdef TILED_RASTERIZATION
+    mRasterize->ClearTiles(Constants::RENDER_CLEAR_CHAR);
+#elif defined(FUSED_RASTERIZATION)
+    mRasterize->InvalidateHierarchicalZ();
+#endif
 
     // init text
     mTextLineIndex = 0;
+
+    // drop draws which weren't executed
+    mDrawCommands->Reset(sizeof(DrawCommand));
 }
 
 void Renderer::EndScene() {
+    // execute recorded draws
+    ExecuteDrawCommands();
+
+#ifdef TILED_RASTERIZATION
+    // gather tiles to render buffer
+    mRasterize->ResolveTiles(reinterpret_cast<wchar_t*>(mRenderBuffer), reinterpret_cast<float*>(mZBuffer), Constants::RENDER_SCREEN_WIDTH);
+#endif
+
+    // move render buffer to conosle buffer
+    memcpy(mConsoleBuffer + Constants::CONSOLE_RENDER_SECTION_START, mRenderBuffer, Constants::RENDER_SCREEN_WIDTH * Constants::RENDER_SCREEN_HEIGHT * sizeof(wchar_t));
+
+    // print to terminal
+    PrintToTerminal();
+
 #ifdef _WIN32
     // flip front & back buffer
     HANDLE temp = mHFrontConsole;
@@ -164,21 +307,15 @@ void Renderer::PrintToTerminal()
 
 void Renderer::RenderCube(const float rotationX, const float rotationY, const float rotationZ) {    
     // vertex shader
+    //      model view projection is calculated once per draw, vertex shader multiplies it to each vertex
     int vertexNum = sizeof(mVertices) / sizeof(mVertices[0]);
+    VertexUniforms uniforms;
+    uniforms.modelViewProjection = CalculateProjection() * CalculateRotation(rotationX, rotationY, rotationZ);
 
-    // todo : pooling
-    Vertex* projVertices = new Vertex[vertexNum];
-    for (int i = 0; i < vertexNum; i++) {
-        TransformVertexPosition(&projVertices[i], mVertices[i], rotationX, rotationY, rotationZ);
-        //TransformVertexPosition(&projVertices[i], mVertices[i], rotationX, 0, 0);        
-    }
-   
+    // all faces at once, character of face is selected by its material
     int indexNum = sizeof(mIndices) / sizeof(mIndices[0]);
-    for (int partIndex = 0; partIndex < indexNum / 6; partIndex++) {
-        wchar_t printChars[6] = { L'@', L'#' , L'$' , L'%' , L'=' , L'&' };
-        mSimplePixelShader->SetCharacter(printChars[partIndex]);
-        Render(projVertices, vertexNum, mIndices + partIndex * 6, 6, mSimplePixelShader);        
-    }
+    mSimplePixelShader->SetMaterialCharacters(mMaterialCharacters, sizeof(mMaterialCharacters) / sizeof(mMaterialCharacters[0]));
+    Render(mVertices, vertexNum, mIndices, indexNum, mSimpleVertexShader, uniforms, mSimplePixelShader, 0, mMaterialIDs);
 
 
     // debugging info : test top-left rule using two triangle contiguous
@@ -207,12 +344,6 @@ void Renderer::RenderCube(const float rotationX, const float rotationY, const fl
     };
     mSimplePixelShader->SetCharacter(L'#');
     Render(vertices, 4, indices, 6, mSimplePixelShader);*/
-    
-
-    // move render buffer to conosle buffer
-    memcpy(mConsoleBuffer + Constants::CONSOLE_RENDER_SECTION_START, mRenderBuffer, Constants::RENDER_SCREEN_WIDTH * Constants::RENDER_SCREEN_HEIGHT * sizeof(wchar_t));
-
-    delete[] projVertices;    
 }
 
 void Renderer::ClearBuffer() {
@@ -221,26 +352,23 @@ void Renderer::ClearBuffer() {
     memsetAnyByte(reinterpret_cast<wchar_t*>(mConsoleBuffer), Constants::CONSOLE_CLEAR_CHAR, Constants::CONSOLE_SCREEN_HEIGHT * Constants::CONSOLE_SCREEN_WIDTH);
 }
 
-void Renderer::TransformVertexPosition(Vertex* pVertex, const Vertex& vertex, const float rotationX, const float rotationY, const float rotationZ)
+Mat4x4 Renderer::CalculateProjection() const
 {
-    assert(pVertex != nullptr);
-
     float near = 1.0f / tanf(Constants::FOVY / 2.0f);
     float far = near + Constants::DST_NEAR_TO_FAR;
-
-    float worldX;
-    float worldY;
-    float worldZ;
-    CalculateRotation(&worldX, &worldY, &worldZ, vertex.pos.x, vertex.pos.y, vertex.pos.z, rotationX, rotationY, rotationZ);
+    float cameraDst = abs(Constants::CAMERA_Z);
 
     // because of font which aspect isn't 1, not calculate aspect in projecting processing.
     // it effects showing normal cube by shorten height of cube when it is rendered
-    float projX = worldX * near;
-    float projY = worldY * near;
-    float projZ = (worldZ + abs(Constants::CAMERA_Z) - near) / (far - near);
-    float projW = worldZ + abs(Constants::CAMERA_Z);
-    
-    pVertex->pos = Vec4(projX, projY, projZ, projW);
+    //      x = worldX * near
+    //      y = worldY * near
+    //      z = (worldZ + cameraDst - near) / (far - near)
+    //      w = worldZ + cameraDst
+    return Mat4x4(
+        Vec4(near, 0.0f, 0.0f, 0.0f),
+        Vec4(0.0f, near, 0.0f, 0.0f),
+        Vec4(0.0f, 0.0f, 1.0f / (far - near), (cameraDst - near) / (far - near)),
+        Vec4(0.0f, 0.0f, 1.0f, cameraDst));
 }
 
 void Renderer::RenderSegmentOnRenderBuffer(const int screenX,
@@ -280,7 +408,7 @@ void Renderer::WriteLinesInConsoleBuffer(wchar_t* consoleBuffer, const wchar_t*
     size_t remainCharLen = Constants::CONSOLE_MAX_TEXT_LEN - mTextLineIndex * Constants::CONSOLE_SCREEN_WIDTH;
     while (remainCharLen > 0) {
         size_t lineCharLen = wcslen(line);
-        memcpy(consoleBuffer + mTextLineIndex * Constants::CONSOLE_SCREEN_WIDTH, line, min(lineCharLen, remainCharLen) * sizeof(wchar_t));
+        memcpy(consoleBuffer + mTextLineIndex * Constants::CONSOLE_SCREEN_WIDTH, line, std::min(lineCharLen, remainCharLen) * sizeof(wchar_t));
         remainCharLen -= Constants::CONSOLE_SCREEN_WIDTH;
 
         mTextLineIndex += lineCharLen / Constants::CONSOLE_SCREEN_WIDTH + 1;
@@ -293,15 +421,7 @@ void Renderer::WriteLinesInConsoleBuffer(wchar_t* consoleBuffer, const wchar_t*
     }
 }
 
-inline void Renderer::CalculateRotation(float* pResultX,
-    float* pResultY,
-    float* pResultZ,
-    const float x,
-    const float y,
-    const float z,
-    const float rotX,
-    const float rotY,
-    const float rotZ)
+Mat4x4 Renderer::CalculateRotation(const float rotX, const float rotY, const float rotZ) const
 {
     float cosA = cos(rotX);
     float cosB = cos(rotY);
@@ -310,9 +430,11 @@ inline void Renderer::CalculateRotation(float* pResultX,
     float sinB = sin(rotY);
     float sinC = sin(rotZ);
 
-    *pResultX = x * cosB * cosC + z * sinB - y * cosB * sinC;
-    *pResultY = x * (sinA * sinB * cosC + cosA * sinC) + y * (cosA * cosC - sinA * sinB * sinC) - z * sinA * cosB;
-    *pResultZ = x * (sinA * sinC - cosA * sinB * cosC) + y * (cosA * sinB * sinC + sinA * cosC) + z * cosA * cosB;
+    return Mat4x4(
+        Vec4(cosB * cosC, -cosB * sinC, sinB, 0.0f),
+        Vec4(sinA * sinB * cosC + cosA * sinC, cosA * cosC - sinA * sinB * sinC, -sinA * cosB, 0.0f),
+        Vec4(sinA * sinC - cosA * sinB * cosC, cosA * sinB * sinC + sinA * cosC, cosA * cosB, 0.0f),
+        Vec4(0.0f, 0.0f, 0.0f, 1.0f));
 }
 
 inline void Renderer::FillEmptyInConsoleBuffer(wchar_t* consoleBuffer, int start, int len)
@@ -8,43 +8,85 @@
 #include <thread>
 #include <iomanip>
 #include <cstdarg>
+#include <algorithm>
+#include <tuple>
 
 #ifdef _WIN32
 #include <Windows.h>
-#undef max
 #undef near
 #undef far
 #endif
-#define min(x, y) (x > y ? y : x)
 
 #include "Constants.h"
 #include "Math.h"
 #include "SWRasterizer.h"
 #include "SimplePixelShader.h"
+#include "SimpleVertexShader.h"
 #include "Primitive.h"
 
 class Renderer {    
 
 public:
-    void Initialize(); // init program
+    void Initialize(RasterizerEngine engine = RasterizerRegistry::DEFAULT_ENGINE); // init program
     void Terminate(); // terminate program
     std::chrono::steady_clock::time_point Frame(std::chrono::steady_clock::time_point prevFrameSec);
-    void Render(const Vertex* vertices, uint32_t vertexNum, const uint32_t* indices, uint32_t indexNum, PixelShader* pixelShader);
+    // draws are recorded and executed at EndScene, sorted by state and depth.
+    //      so vertices, indices, materialIDs and state of shaders must be kept until EndScene. uniforms are copied
+    // vertexShader transforms vertices to clip space with uniforms
+    // first varyingNum varyings of vertices reach pixel shader perspective correctly
+    // materialIDs : material of each triangle, which pixel shader gets with pixels. optional
+    void Render(const Vertex* vertices, uint32_t vertexNum, const uint32_t* indices, uint32_t indexNum,
+        VertexShader* vertexShader, const VertexUniforms& uniforms, PixelShader* pixelShader,
+        uint32_t varyingNum = 0, const uint32_t* materialIDs = nullptr);
+    // vertices are already in clip space
+    void Render(const Vertex* vertices, uint32_t vertexNum, const uint32_t* indices, uint32_t indexNum, PixelShader* pixelShader,
+        uint32_t varyingNum = 0, const uint32_t* materialIDs = nullptr);
+    // viewport of draws recorded after it
+    void SetViewport(const SWRasterizer::Viewport& viewport);
+    // rasterizer engine of draws recorded after it
+    void SetRasterizerEngine(RasterizerEngine engine);
+
+private:
+    // recorded draw, executed at EndScene
+    struct DrawCommand {
+        ArrayView<Vertex> vertices;
+        ArrayView<uint32_t> indices;
+        VertexShader* vertexShader;
+        VertexUniforms vertexUniforms;
+        PixelShader* pixelShader;
+        uint32_t varyingNum;
+        const uint32_t* materialIDs;
+        SWRasterizer::Viewport viewport;
+        RasterizerEngine engine;
+        // clip space w of nearest vertex. near draws are executed first to reject more pixels by depth
+        float depthKey;
+        // order of record, keeps order of draws which have same key
+        uint32_t order;
+    };
+
+    static constexpr uint64_t RESERVED_DRAW_COMMAND_NUM = 64;
 
 private:
     void BeginScene(); // start of render
     void EndScene(); // end of render
 
+    // sort recorded draws by viewport, shaders, depth and execute them.
+    //      state is changed only between draws which have different state
+    void ExecuteDrawCommands();
+    void ExecuteDrawCommand(const DrawCommand& command);
+    static inline bool IsSameViewport(const SWRasterizer::Viewport& a, const SWRasterizer::Viewport& b) {
+        return a.leftX == b.leftX && a.topY == b.topY && a.width == b.width && a.height == b.height
+            && a.minZ == b.minZ && a.maxZ == b.maxZ;
+    }
+
     void PrintToTerminal();
     // move to outside of Renderer
     void RenderCube(const float rotationX, const float rotationY, const float rotationZ);
     void ClearBuffer();
-        
-    void TransformVertexPosition(Vertex* pVertex,
-        const Vertex& vertex,
-        const float rotationX,
-        const float rotationY,
-        const float rotationZ);
+
+    // model view projection of cube
+    Mat4x4 CalculateProjection() const;
+    Mat4x4 CalculateRotation(const float rotX, const float rotY, const float rotZ) const;
 
 
     void RenderSegmentOnRenderBuffer(const int screenX,
@@ -58,15 +100,6 @@ private:
     //      helper
     inline void FillEmptyInConsoleBuffer(wchar_t* consoleBuffer, int start, int len);
 
-    inline void CalculateRotation(float* pResultX,
-        float* pResultY,
-        float* pResultZ,
-        const float x,
-        const float y,
-        const float z,
-        const float rotX,
-        const float rotY,
-        const float rotZ);
     //      source : https://stackoverflow.com/a/57740899
     template<typename T>
     static inline void memsetAnyByte(T* __restrict dst, T val, int len) {
@@ -149,6 +182,17 @@ private:
         3, 1, 2
     };
 
+    // a face is 2 triangles, and each face is printed by its own character
+    const uint32_t mMaterialIDs[12]{
+        0, 0,
+        1, 1,
+        2, 2,
+        3, 3,
+        4, 4,
+        5, 5
+    };
+    const wchar_t mMaterialCharacters[6]{ L'@', L'#', L'$', L'%', L'=', L'&' };
+
     // related with text
     int mTextLineIndex = 0;
     wchar_t mTextBuffer[Constants::TEXT_BUFFER_SIZE];
@@ -165,6 +209,18 @@ private:
     PixelShaderManager* mPixelShaderManager = nullptr;
     SimplePixelShader* mSimplePixelShader =nullptr;
 
+    // vertexShader
+    SimpleVertexShader* mSimpleVertexShader = nullptr;
+
+    // draw commands recorded in scene
+    List* mDrawCommands = nullptr;
+
     // viewport
+    //      mViewport is recorded in draws, mAppliedViewport is set in rasterizer
     SWRasterizer::Viewport mViewport;
+    SWRasterizer::Viewport mAppliedViewport;
+
+    // rasterizer engine
+    //      mEngine is recorded in draws, engine set in rasterizer is its own
+    RasterizerEngine mEngine;
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "Math.h"
 #include <memory>
 #include <cassert>
+#include <limits>
+#include <immintrin.h>
 #include <windows.h>
 
 SWRasterizer::SWRasterizer() 
@@ -9,19 +11,45 @@ SWRasterizer::SWRasterizer()
 
 }
 
-void SWRasterizer::Initialize()
+void SWRasterizer::Initialize(uint32_t renderTargetWidth, uint32_t renderTargetHeight, RasterizerEngine engine)
 {
 	mVerticesPool[0] = new List(1, RESERVED_VERTICES_BYTES);
 	mVerticesPool[1] = new List(1, RESERVED_VERTICES_BYTES);
 	mIndicesPool[0] = new List(1, RESERVED_INDICES_BYTES);
 	mIndicesPool[1] = new List(1, RESERVED_INDICES_BYTES);
+	mMaterialIDsPool[0] = new List(1, RESERVED_MATERIAL_IDS_BYTES);
+	mMaterialIDsPool[1] = new List(1, RESERVED_MATERIAL_IDS_BYTES);
 	mPixels = new List(1, RESERVED_PIXELS_BYTES);
-
-#ifdef FIXED_RASTERIZATION
-	mRasterize = new RasterizeFixed;
-#else
-	mRasterize = new RasterizeFloating;
+	mSpans = new List(1, RESERVED_SPANS_BYTES);
+	mShadedVertices = new List(1, RESERVED_VERTICES_BYTES);
+	mShadedVertices->Reset(sizeof(Vertex));
+	mOutcodes = new List(1, RESERVED_OUTCODES_BYTES);
+	mVertexRemap = new List(1, RESERVED_VERTEX_REMAP_BYTES);
+	mVertexRemap->Reset(sizeof(uint32_t));
+	for (int c = 0; c < 4; c++) {
+		mPositionStreams[c] = new List(1, RESERVED_POSITION_STREAM_BYTES);
+		mPositionStreams[c]->Reset(sizeof(float));
+	}
+	mVaryingStream = new List(1, RESERVED_POSITION_STREAM_BYTES);
+	mVaryingStream->Reset(sizeof(float));
+	ResizeClipEdges(RESERVED_CLIP_EDGE_NUM);
+
+	mRenderTargetWidth = renderTargetWidth;
+	mRenderTargetHeight = renderTargetHeight;
+
+	mEngine = engine;
+	ResetRasterizers();
+
+#ifdef TILED_RASTERIZATION
+	// calling thread of ExecuteTiled works too
+	uint32_t hardwareThreadNum = std::thread::hardware_concurrency();
+	uint32_t workerThreadNum = hardwareThreadNum > 1 ? hardwareThreadNum - 1 : 0;
+
+	mTileRasterizer = new TileRasterizer;
+	mTileRasterizer->Initialize(GetRenderTargetRect(), workerThreadNum, mEngine, mFixedPointPrecision);
 #endif
+
+	mHierarchicalZ = new HierarchicalZ;
 }
 
 void SWRasterizer::Terminate()
@@ -46,19 +74,220 @@ void SWRasterizer::Terminate()
 		mIndicesPool[1] = nullptr;
 	}
 
+	for (int i = 0; i < 2; i++) {
+		if (mMaterialIDsPool[i]) {
+			delete mMaterialIDsPool[i];
+			mMaterialIDsPool[i] = nullptr;
+		}
+	}
+
 	if (mPixels) {
 		delete mPixels;
 		mPixels = nullptr;
 	}
 
-	if (mRasterize) {
-		delete mRasterize;
-		mRasterize = nullptr;
+	if (mSpans) {
+		delete mSpans;
+		mSpans = nullptr;
+	}
+
+	if (mShadedVertices) {
+		delete mShadedVertices;
+		mShadedVertices = nullptr;
+	}
+
+	if (mOutcodes) {
+		delete mOutcodes;
+		mOutcodes = nullptr;
+	}
+
+	if (mVertexRemap) {
+		delete mVertexRemap;
+		mVertexRemap = nullptr;
+	}
+
+	for (int c = 0; c < 4; c++) {
+		if (mPositionStreams[c]) {
+			delete mPositionStreams[c];
+			mPositionStreams[c] = nullptr;
+		}
+	}
+
+	if (mVaryingStream) {
+		delete mVaryingStream;
+		mVaryingStream = nullptr;
+	}
+
+	if (mClipEdges) {
+		delete[] mClipEdges;
+		mClipEdges = nullptr;
+		mClipEdgeCapacity = 0;
+		mClipEdgeNum = 0;
+	}
+
+	if (mFloatingRasterize) {
+		delete mFloatingRasterize;
+		mFloatingRasterize = nullptr;
+	}
+
+	if (mFixedRasterize) {
+		delete mFixedRasterize;
+		mFixedRasterize = nullptr;
+	}
+
+	if (mTriangleSetup) {
+		delete mTriangleSetup;
+		mTriangleSetup = nullptr;
+	}
+
+	if (mTileRasterizer) {
+		mTileRasterizer->Terminate();
+		delete mTileRasterizer;
+		mTileRasterizer = nullptr;
+	}
+
+	if (mHierarchicalZ) {
+		delete mHierarchicalZ;
+		mHierarchicalZ = nullptr;
+	}
+}
+
+void SWRasterizer::SetRasterizerEngine(RasterizerEngine engine)
+{
+	if (engine == mEngine) {
+		return;
+	}
+
+	mEngine = engine;
+	ResetRasterizers();
+	SetupGuardBand();
+}
+
+void SWRasterizer::ResetRasterizers()
+{
+	delete mFloatingRasterize;
+	mFloatingRasterize = nullptr;
+	delete mFixedRasterize;
+	mFixedRasterize = nullptr;
+	delete mTriangleSetup;
+	mTriangleSetup = nullptr;
+	if (RasterizerRegistry::GetEntry(mEngine).isFixedPoint) {
+		mFixedRasterize = RasterizerRegistry::CreateFixed(mEngine, mFixedPointPrecision);
+		mTriangleSetup = RasterizerRegistry::CreateTriangleSetup(mFixedPointPrecision);
+	}
+	else {
+		mFloatingRasterize = RasterizerRegistry::CreateFloating(mEngine);
+	}
+
+	if (mTileRasterizer) {
+		mTileRasterizer->SetRasterizerEngine(mEngine, mFixedPointPrecision);
+	}
+}
+
+void SWRasterizer::Execute(const ArrayView<Vertex>& vertices, const ArrayView<uint32_t>& indices, uint32_t varyingNum,
+	const uint32_t* materialIDs)
+{
+	const List* viewportVertices = nullptr;
+	const List* rasterVertices = nullptr;
+	const List* culledIndices = nullptr;
+	const List* culledMaterialIDs = nullptr;
+	ProcessGeometry(&viewportVertices, &rasterVertices, &culledIndices, &culledMaterialIDs,
+		vertices, indices, varyingNum, materialIDs);
+
+	PixelOutput output(mPixels, mSpans);
+	if (mFixedRasterize) {
+		mFixedRasterize->Rasterize(&output, rasterVertices, *mTriangleSetup, nullptr, GetScissorRect(), mVaryingNum);
+	}
+	else {
+		mFloatingRasterize->Rasterize(&output, rasterVertices, culledIndices, culledMaterialIDs, GetScissorRect(), mVaryingNum);
+	}
+
+#ifdef DEBUG_PROCESS_COORDINATE
+	std::cout << "pixel" << std::endl;
+	for (int i = 0; i < mPixels->GetSize(); i++) {
+		std::cout << i << " : " << mPixels->At<Pixel>(i).pos << std::endl;
+	}
+
+	std::cout << "end rasterization" << std::endl;
+#endif
+}
+
+void SWRasterizer::ExecuteTiled(const ArrayView<Vertex>& vertices, const ArrayView<uint32_t>& indices, PixelShader* pixelShader,
+	uint32_t varyingNum, const uint32_t* materialIDs)
+{
+	assert(mTileRasterizer != nullptr);
+
+	const List* viewportVertices = nullptr;
+	const List* rasterVertices = nullptr;
+	const List* culledIndices = nullptr;
+	const List* culledMaterialIDs = nullptr;
+	ProcessGeometry(&viewportVertices, &rasterVertices, &culledIndices, &culledMaterialIDs,
+		vertices, indices, varyingNum, materialIDs);
+
+	// binning
+	//		fixed point engines bin triangles of setup, which workers share
+	if (mTriangleSetup) {
+		mTileRasterizer->Bin(mTriangleSetup);
+	}
+	else {
+		mTileRasterizer->Bin(viewportVertices, culledIndices, culledMaterialIDs);
+	}
+
+	// rasterize, pixel shader, depth test on each tile
+	mTileRasterizer->Execute(rasterVertices, mVaryingNum, pixelShader);
+}
+
+void SWRasterizer::ExecuteFused(const ArrayView<Vertex>& vertices, const ArrayView<uint32_t>& indices, PixelShader* pixelShader,
+	wchar_t* renderBuffer, float* zBuffer, uint32_t pitch, uint32_t varyingNum, const uint32_t* materialIDs)
+{
+	const List* viewportVertices = nullptr;
+	const List* rasterVertices = nullptr;
+	const List* culledIndices = nullptr;
+	const List* culledMaterialIDs = nullptr;
+	ProcessGeometry(&viewportVertices, &rasterVertices, &culledIndices, &culledMaterialIDs,
+		vertices, indices, varyingNum, materialIDs);
+
+	// rasterize, pixel shader, depth test per pixel
+	ScissorRect scissorRect = GetScissorRect();
+	if (scissorRect.leftX >= scissorRect.rightX || scissorRect.topY >= scissorRect.bottomY) {
+		return;
+	}
+	mHierarchicalZ->Setup(scissorRect, zBuffer + scissorRect.topY * pitch + scissorRect.leftX, pitch);
+	PixelOutput output(pixelShader, renderBuffer, zBuffer, pitch, 0, 0, mHierarchicalZ);
+	if (mFixedRasterize) {
+		mFixedRasterize->Rasterize(&output, rasterVertices, *mTriangleSetup, nullptr, scissorRect, mVaryingNum);
+	}
+	else {
+		mFloatingRasterize->Rasterize(&output, rasterVertices, culledIndices, culledMaterialIDs, scissorRect, mVaryingNum);
 	}
 }
 
-void SWRasterizer::Execute(const Vertex* vertices, int vertexNum, const uint32_t* indices, int indexNum)
+void SWRasterizer::InvalidateHierarchicalZ()
 {
+	assert(mHierarchicalZ != nullptr);
+
+	mHierarchicalZ->Invalidate();
+}
+
+void SWRasterizer::ClearTiles(wchar_t clearChar)
+{
+	assert(mTileRasterizer != nullptr);
+
+	mTileRasterizer->Clear(clearChar);
+}
+
+void SWRasterizer::ResolveTiles(wchar_t* renderBuffer, float* zBuffer, uint32_t pitch) const
+{
+	assert(mTileRasterizer != nullptr);
+
+	mTileRasterizer->Resolve(renderBuffer, zBuffer, pitch);
+}
+
+void SWRasterizer::ProcessGeometry(const List** pViewportVertices, const List** pRasterVertices, const List** pCulledIndices, const List** pMaterialIDs,
+	const ArrayView<Vertex>& vertices, const ArrayView<uint32_t>& indices, uint32_t varyingNum, const uint32_t* materialIDs)
+{
+	assert(varyingNum <= MAX_VARYING_NUM);
+
 	// clear vertex, index pool
 	for (int i = 0; i < sizeof(mVerticesPool) / sizeof(mVerticesPool[0]); i++) {
 		mVerticesPool[i]->Reset(sizeof(Vertex));
@@ -66,41 +295,63 @@ void SWRasterizer::Execute(const Vertex* vertices, int vertexNum, const uint32_t
 
 	for (int i = 0; i < sizeof(mIndicesPool) / sizeof(mIndicesPool[0]); i++) {
 		mIndicesPool[i]->Reset(sizeof(uint32_t));
+		mMaterialIDsPool[i]->Reset(sizeof(uint32_t));
 	}
 
 	// clear pixel list
 	mPixels->Reset(sizeof(Pixel));
+	mSpans->Reset(sizeof(Span));
 
 	
-	mVertexNum = vertexNum;
-	mIndexNum = indexNum;
+	mClipVertices = mVerticesPool[0];
+	mVaryingNum = varyingNum;
+
+	// vertex shader
+	//		without it, vertices are in clip space and read in place
+	mInputVertices = vertices;
+	if (mVertexShader != nullptr) {
+		mShadedVertices->Resize(vertices.num);
+		mVertexShader->Execute(mVertexUniforms, vertices, varyingNum, mShadedVertices->GetData<Vertex>());
+		mInputVertices = ArrayView<Vertex>(mShadedVertices->GetData<Vertex>(), vertices.num);
+	}
 
 #ifdef DEBUG_PROCESS_COORDINATE
 	SetConsoleActiveScreenBuffer(GetStdHandle(STD_OUTPUT_HANDLE));
 	std::cout << "vertex" << std::endl;
-	for (int i = 0; i < vertexNum; i++) {
+	for (uint32_t i = 0; i < vertices.num; i++) {
 		std::cout << i << " : " << vertices[i].pos << std::endl;
 	}
 
 	std::cout << "index" << std::endl;
-	for (int i = 0; i < indexNum; i++) {
+	for (uint32_t i = 0; i < indices.num; i++) {
 		std::cout << i << " : " << indices[i] << std::endl;
 	}
 #endif
 
+	// back face culling in homogeneous space
+	//		input vertices, indices are read in place
+	List* culledIndices = mIndicesPool[1];
+	//		material of triangle follows it through culling and clipping. without materials, nothing is tracked
+	List* culledMaterialIDs = materialIDs != nullptr ? mMaterialIDsPool[1] : nullptr;
+	CullBackFace(&culledIndices, culledMaterialIDs ? &culledMaterialIDs : nullptr, indices, materialIDs);
+
+#ifdef DEBUG_PROCESS_COORDINATE
+	std::cout << "cull back face" << std::endl;
+	for (int i = 0; i < culledIndices->GetSize(); i++) {
+		std::cout << i << " : " << culledIndices->At<uint32_t>(i) << std::endl;
+	}
+#endif
+
 	// clip
-	List* preClippedVertices = mVerticesPool[0];
-	List* preClippedIndices = mIndicesPool[0];
-	List* clippedVertices = mVerticesPool[1];
-	List* clippedIndices = mIndicesPool[1];
-	preClippedVertices->Add<Vertex>(vertices, vertexNum);
-	preClippedIndices->Add<uint32_t>(indices, indexNum);
-	Clip(&clippedVertices, &clippedIndices, preClippedVertices, preClippedIndices);
+	//		vertices are shared through clipping, so only vertices created by clipping are stored in mClipVertices
+	List* clippedIndices = mIndicesPool[0];
+	List* clippedMaterialIDs = materialIDs != nullptr ? mMaterialIDsPool[0] : nullptr;
+	Clip(&clippedIndices, clippedMaterialIDs ? &clippedMaterialIDs : nullptr, culledIndices, culledMaterialIDs);
 
 #ifdef DEBUG_PROCESS_COORDINATE
 	std::cout << "clip vertex" << std::endl;
-	for (int i = 0; i < clippedVertices->GetSize(); i++) {
-		std::cout << i << " : " << (clippedVertices->At<Vertex>(i)).pos << std::endl;
+	for (uint32_t i = 0; i < GetVertexNum(); i++) {
+		std::cout << i << " : " << GetVertex(i).pos << std::endl;
 	}
 
 	std::cout << "clip index" << std::endl;
@@ -109,155 +360,236 @@ void SWRasterizer::Execute(const Vertex* vertices, int vertexNum, const uint32_t
 	}
 #endif
 
-	// perspective division
-	DividePerspective(&clippedVertices);
+	// only vertices referenced by remain triangles are processed after here
+	CompactVertices(&clippedIndices);
 
-#ifdef DEBUG_PROCESS_COORDINATE
-	std::cout << "perspective deivision" << std::endl;
-	for (int i = 0; i < clippedVertices->GetSize(); i++) {
-		std::cout << i << " : " << (clippedVertices->At<Vertex>(i)).pos << std::endl;
+	// perspective division, transform viewport and convert to fixed point at once
+	bool isFixedPoint = RasterizerRegistry::GetEntry(mEngine).isFixedPoint;
+	List* viewportVertices = mVerticesPool[1];
+	//		vertices created by clipping are in streams now, so their pool is reused
+	List* fixedVertices = isFixedPoint ? mVerticesPool[0] : nullptr;
+	viewportVertices->Reset(sizeof(Vertex));
+	if (fixedVertices) {
+		fixedVertices->Reset(sizeof(FixedVertex));
 	}
-#endif
-
-	// back face culling
-	List* culledIndices = preClippedIndices;
-	culledIndices->Reset(sizeof(uint32_t));
-	CullBackFace(&culledIndices, clippedIndices, clippedVertices);
+	TransformVertices(&viewportVertices, fixedVertices ? &fixedVertices : nullptr);
 
 #ifdef DEBUG_PROCESS_COORDINATE
-	std::cout << "cull back face" << std::endl;
-	for (int i = 0; i < culledIndices->GetSize(); i++) {
-		std::cout << i << " : " << culledIndices->At<uint32_t>(i) << std::endl;
+	std::cout << "transform viewport" << std::endl;
+	for (int i = 0; i < viewportVertices->GetSize(); i++) {
+		std::cout << i << " : " << (viewportVertices->At<Vertex>(i)).pos << std::endl;
+	}
+
+	if (fixedVertices) {
+		std::cout << "fixed point" << std::endl;
+		for (int i = 0; i < fixedVertices->GetSize(); i++) {
+			std::cout << i << " : " << (fixedVertices->At<FixedVertex>(i)).pos << std::endl;
+		}
 	}
 #endif
 
-	// TODO : after back face culling, only do remain process with vertices not culled.
+	// fixed point engines set up triangles once in draw, not in each tile
+	if (mTriangleSetup) {
+		mTriangleSetup->Setup(fixedVertices, clippedIndices, clippedMaterialIDs, GetViewportRect());
+	}
+
+	*pViewportVertices = viewportVertices;
+	*pRasterVertices = isFixedPoint ? fixedVertices : viewportVertices;
+	*pCulledIndices = clippedIndices;
+	*pMaterialIDs = clippedMaterialIDs;
+}
 
-	// transform viewport
-	TransformViewport(&clippedVertices);
 
-#ifdef DEBUG_PROCESS_COORDINATE
-	std::cout << "transform viewport" << std::endl;
-	for (int i = 0; i < clippedVertices->GetSize(); i++) {
-		std::cout << i << " : " << (clippedVertices->At<Vertex>(i)).pos << std::endl;
-	}
-#endif
+void SWRasterizer::SetupViewport(const Viewport& viewport)
+{
+	mViewport = viewport;
 
-	// convert to fixed point
-#ifdef FIXED_RASTERIZATION	
-	List* fixedVertices = preClippedVertices;
-	fixedVertices->Reset(sizeof(FixedVertex));
-	ConvertFixedPoint(&fixedVertices, clippedVertices);
+	FixedPointPrecision precision = RasterizerRegistry::SelectFixedPointPrecision(GetViewportRect());
+	if (precision != mFixedPointPrecision) {
+		mFixedPointPrecision = precision;
+		ResetRasterizers();
+	}
+	SetupGuardBand();
 
-#ifdef DEBUG_PROCESS_COORDINATE
-	std::cout << "fixed point" << std::endl;
-	for (int i = 0; i < fixedVertices->GetSize(); i++) {
-		std::cout << i << " : " << (fixedVertices->At<FixedVertex>(i)).pos << std::endl;
+	if (mTileRasterizer) {
+		mTileRasterizer->SetupViewport(GetViewportRect());
 	}
-#endif
+}
 
-	mRasterize->Rasterize(mPixels, fixedVertices, culledIndices);
-#else
-	mRasterize->Rasterize(mPixels, clippedVertices, culledIndices);
-#endif
+void SWRasterizer::SetupVertexShader(VertexShader* vertexShader, const VertexUniforms& uniforms)
+{
+	mVertexShader = vertexShader;
+	mVertexUniforms = uniforms;
+}
 
-	
-	
+void SWRasterizer::SetupGuardBand()
+{
+	float guardBandMin = 0.0f;
+	float guardBandMax = 0.0f;
+	if (!RasterizerRegistry::GetGuardBand(mEngine, mFixedPointPrecision, &guardBandMin, &guardBandMax)) {
+		mGuardBandMinX = -1.0f;
+		mGuardBandMaxX = 1.0f;
+		mGuardBandMinY = -1.0f;
+		mGuardBandMaxY = 1.0f;
+		return;
+	}
 
-	//RasterizeFixedPoint(fixedVertices, culledIndices);
+	// inverse of viewport transform on guard band. +y of viewport is down
+	assert(mViewport.leftX + mViewport.width <= guardBandMax && mViewport.topY + mViewport.height <= guardBandMax);
+	mGuardBandMinX = (guardBandMin - mViewport.leftX) * 2.0f / mViewport.width - 1.0f;
+	mGuardBandMaxX = (guardBandMax - mViewport.leftX) * 2.0f / mViewport.width - 1.0f;
+	mGuardBandMinY = 1.0f - (guardBandMax - mViewport.topY) * 2.0f / mViewport.height;
+	mGuardBandMaxY = 1.0f - (guardBandMin - mViewport.topY) * 2.0f / mViewport.height;
+}
 
-#ifdef DEBUG_PROCESS_COORDINATE
-	std::cout << "pixel" << std::endl;
-	for (int i = 0; i < mPixels->GetSize(); i++) {
-		std::cout << i << " : " << mPixels->At<Pixel>(i).pos << std::endl;
-	}
+inline ScissorRect SWRasterizer::GetViewportRect() const
+{
+	ScissorRect rect;
+	rect.leftX = static_cast<int32_t>(mViewport.leftX);
+	rect.topY = static_cast<int32_t>(mViewport.topY);
+	rect.rightX = static_cast<int32_t>(mViewport.leftX + mViewport.width);
+	rect.bottomY = static_cast<int32_t>(mViewport.topY + mViewport.height);
 
-	std::cout << "end rasterization" << std::endl;
-#endif
+	return rect;
 }
 
+inline ScissorRect SWRasterizer::GetRenderTargetRect() const
+{
+	return { 0, 0, static_cast<int32_t>(mRenderTargetWidth), static_cast<int32_t>(mRenderTargetHeight) };
+}
 
-void SWRasterizer::SetupViewport(const Viewport& viewport)
+inline ScissorRect SWRasterizer::GetScissorRect() const
 {
-	mViewport = viewport;
+	ScissorRect viewportRect = GetViewportRect();
+	ScissorRect renderTargetRect = GetRenderTargetRect();
+
+	ScissorRect rect;
+	rect.leftX = std::max(viewportRect.leftX, renderTargetRect.leftX);
+	rect.topY = std::max(viewportRect.topY, renderTargetRect.topY);
+	rect.rightX = std::min(viewportRect.rightX, renderTargetRect.rightX);
+	rect.bottomY = std::min(viewportRect.bottomY, renderTargetRect.bottomY);
+
+	return rect;
 }
 
-void SWRasterizer::Clip(List** pClippedVertices, List** pClippedIndices, const List* vertices, const List* indices)
+void SWRasterizer::Clip(List** pClippedIndices, List** pClippedMaterialIDs, const List* indices, const List* materialIDs)
 {
-	Vertex clippedVertices[9];
-	uint32_t clippedIndices[21];
+	// triangles before clipping have only input vertices
+	List* outcodes = mOutcodes;
+	outcodes->Reset(sizeof(uint8_t));
+	CalculateOutcodes(&outcodes);
+
+	ResetClipEdges();
 
 	int indexLen = indices->GetSize();
 	for (int indexIdx = 0; indexIdx < indexLen; indexIdx+=3) {		
-		Vertex v1 = vertices->At<Vertex>(indices->At<uint32_t>(indexIdx));
-		Vertex v2 = vertices->At<Vertex>(indices->At<uint32_t>(indexIdx + 1));
-		Vertex v3 = vertices->At<Vertex>(indices->At<uint32_t>(indexIdx + 2));
-		Triangle tri = { v1, v2, v3};
-
-		uint8_t clippedVertexNum = 0;
-		uint8_t clippedIndexNum = 0;
-		bool isClipped = false;
-		ClipTriangle(&isClipped, &clippedIndexNum, &clippedVertexNum, clippedVertices, clippedIndices, tri);		
-
-		for (int i = 0; i < clippedIndexNum; i++) {
-			(*pClippedIndices)->Add<uint32_t>((*pClippedVertices)->GetSize() + clippedIndices[i]);
+		uint32_t triangleIndices[3] = {
+			indices->At<uint32_t>(indexIdx),
+			indices->At<uint32_t>(indexIdx + 1),
+			indices->At<uint32_t>(indexIdx + 2)
+		};
+		uint8_t outcode1 = outcodes->At<uint8_t>(triangleIndices[0]);
+		uint8_t outcode2 = outcodes->At<uint8_t>(triangleIndices[1]);
+		uint8_t outcode3 = outcodes->At<uint8_t>(triangleIndices[2]);
+
+		// trivial reject. all vertices are out of same plane
+		if ((outcode1 & outcode2 & outcode3) != 0) {
+			continue;
 		}
 
-		for (int i = 0; i < clippedVertexNum; i++) {
-			(*pClippedVertices)->Add<Vertex>(clippedVertices[i]);
-		}		
+		// trivial accept. all vertices are in all planes, so triangle keeps its vertices
+		uint8_t crossedPlaneMask = outcode1 | outcode2 | outcode3;
+		if (crossedPlaneMask == 0) {
+			(*pClippedIndices)->Add<uint32_t>(triangleIndices, 3);
+			if (pClippedMaterialIDs != nullptr) {
+				(*pClippedMaterialIDs)->Add<uint32_t>(materialIDs->At<uint32_t>(indexIdx / 3));
+			}
+			continue;
+		}
+
+		uint64_t preIndexLen = (*pClippedIndices)->GetSize();
+		ClipTriangle(pClippedIndices, triangleIndices, crossedPlaneMask);
+		if (pClippedMaterialIDs != nullptr) {
+			uint32_t materialID = materialIDs->At<uint32_t>(indexIdx / 3);
+			for (uint64_t i = preIndexLen; i < (*pClippedIndices)->GetSize(); i += 3) {
+				(*pClippedMaterialIDs)->Add<uint32_t>(materialID);
+			}
+		}
 	}
 }
 
-void SWRasterizer::ClipTriangle(bool* pIsClipped, uint8_t* pClippedIndexNum, uint8_t* pClippedVertexNum, Vertex(&clippedVertices)[9], uint32_t(&clippedIndices)[21], const Triangle& triangle)
-{	
-	*pIsClipped = false;
+void SWRasterizer::CalculateOutcodes(List** pOutcodes)
+{
+	// compare (x, y, z, w) with lower, upper bound of planes at once
+	//		lower : (guard band min x * w, guard band min y * w, 0, -inf)
+	//		upper : (guard band max x * w, guard band max y * w, w, +inf)
+	const __m128 minScales = _mm_setr_ps(mGuardBandMinX, mGuardBandMinY, 0.0f, 0.0f);
+	const __m128 maxScales = _mm_setr_ps(mGuardBandMaxX, mGuardBandMaxY, 1.0f, 0.0f);
+	const __m128 minOffsets = _mm_setr_ps(0.0f, 0.0f, 0.0f, -(std::numeric_limits<float>::infinity)());
+	const __m128 maxOffsets = _mm_setr_ps(0.0f, 0.0f, 0.0f, (std::numeric_limits<float>::infinity)());
+
+	for (uint32_t i = 0; i < mInputVertices.num; i++) {
+		__m128 pos = _mm_loadu_ps(&mInputVertices[i].pos.x);
+		__m128 w = _mm_shuffle_ps(pos, pos, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 lower = _mm_add_ps(_mm_mul_ps(minScales, w), minOffsets);
+		__m128 upper = _mm_add_ps(_mm_mul_ps(maxScales, w), maxOffsets);
+
+		// bit 0, 1, 2 : x, y, z
+		uint32_t underMask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(pos, lower)));
+		uint32_t overMask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmpgt_ps(pos, upper)));
+
+		// spread to -x, +x, -y, +y, -z, +z order of PlaneID
+		uint8_t outcode = static_cast<uint8_t>(
+			(underMask & 1) | ((underMask & 2) << 1) | ((underMask & 4) << 2)
+			| ((overMask & 1) << 1) | ((overMask & 2) << 2) | ((overMask & 4) << 3));
+		(*pOutcodes)->Add<uint8_t>(outcode);
+	}
+}
 
+void SWRasterizer::ClipTriangle(List** pClippedIndices, const uint32_t(&triangleIndices)[3], uint8_t planeMask)
+{	
 	int vertexNum = 3;
-	// clip vertex buffer size : triangle vertex 3 + can be added vertex 6
+	// clip polygon buffer size : triangle vertex 3 + can be added vertex 6
 	//		During one clip on one plane, can be added max 1 vertex
-	// TODO : move to member
-	Vertex buffer1[9];	
-	Vertex buffer2[9];
-	Vertex* unClippedVertices = buffer1;
-	Vertex* partClippedVertices = buffer2;	
+	uint32_t buffer1[9];
+	uint32_t buffer2[9];
+	uint32_t* unClippedIndices = buffer1;
+	uint32_t* partClippedIndices = buffer2;
 	for (int i = 0; i < 3; i++) {
-		unClippedVertices[i] = triangle.vertices[i];
+		unClippedIndices[i] = triangleIndices[i];
 	}
 
-
 	// clipping
 	int planeLen = static_cast<int>(PlaneID::Length);
 	for (int planeID = 0; planeID < planeLen; planeID++) {		
+		// all vertices are in plane
+		if ((planeMask & (1 << planeID)) == 0) {
+			continue;
+		}
 		
 		int partClippedVertexIndex = 0;
-		const Vertex* pPrevV = &unClippedVertices[0];
-		bool isPrevVInPlane = IsInPlane(static_cast<PlaneID>(planeID), *pPrevV);
+		uint32_t prevIndex = unClippedIndices[0];
+		bool isPrevVInPlane = IsInPlane(static_cast<PlaneID>(planeID), GetVertex(prevIndex));
 		for (int vertexIdx = 1; vertexIdx < vertexNum + 1; vertexIdx++) {			
-			const Vertex& v = unClippedVertices[vertexIdx % vertexNum];						
-			bool isVInPlane = IsInPlane(static_cast<PlaneID>(planeID), v);
+			uint32_t index = unClippedIndices[vertexIdx % vertexNum];
+			bool isVInPlane = IsInPlane(static_cast<PlaneID>(planeID), GetVertex(index));
 
 			// all in
 			if (isPrevVInPlane && isVInPlane) {
-				partClippedVertices[partClippedVertexIndex++] = v;
+				partClippedIndices[partClippedVertexIndex++] = index;
 			}
 			// v1 in
 			else if (isPrevVInPlane) {		
-				*pIsClipped = true;
-				partClippedVertices[partClippedVertexIndex++] = CalculateInterVertex(static_cast<PlaneID>(planeID), *pPrevV, v);;
+				partClippedIndices[partClippedVertexIndex++] = GetInterVertexIndex(static_cast<PlaneID>(planeID), prevIndex, index);
 			}
 			// v2 in
 			else if (isVInPlane) {
-				*pIsClipped = true;
-				partClippedVertices[partClippedVertexIndex++] = CalculateInterVertex(static_cast<PlaneID>(planeID), *pPrevV, v);
-				partClippedVertices[partClippedVertexIndex++] = v;
-			}
-			else {
-				*pIsClipped = true;
+				partClippedIndices[partClippedVertexIndex++] = GetInterVertexIndex(static_cast<PlaneID>(planeID), index, prevIndex);
+				partClippedIndices[partClippedVertexIndex++] = index;
 			}
 
 			// swap 			
-			pPrevV = &v;
+			prevIndex = index;
 			isPrevVInPlane = isVInPlane;
 		}
 
@@ -267,49 +599,113 @@ void SWRasterizer::ClipTriangle(bool* pIsClipped, uint8_t* pClippedIndexNum, uin
 			break;			
 		}
 
-		if (planeID != planeLen - 1) {
-			auto* temp = unClippedVertices;
-			unClippedVertices = partClippedVertices;
-			partClippedVertices = temp;
-		}			
+		auto* temp = unClippedIndices;
+		unClippedIndices = partClippedIndices;
+		partClippedIndices = temp;
 	}
 
-	// return
 	// if triangle doesn't be created
 	if (vertexNum - 2 < 0) {
-		*pClippedVertexNum = 0;
-		*pClippedIndexNum = 0;
 		return;
 	}
 
-	// set vertex
-	memcpy(clippedVertices, partClippedVertices, sizeof(Vertex) * vertexNum);
-	// set indices
+	// triangle fan of clipped polygon
 	for (int i = 0; i < (vertexNum - 2); i++) {
-		clippedIndices[i * 3] = 0;
-		clippedIndices[i * 3 + 1] = (i + 1) % vertexNum;
-		clippedIndices[i * 3 + 2] = (i + 2) % vertexNum;
+		(*pClippedIndices)->Add<uint32_t>(unClippedIndices[0]);
+		(*pClippedIndices)->Add<uint32_t>(unClippedIndices[i + 1]);
+		(*pClippedIndices)->Add<uint32_t>(unClippedIndices[i + 2]);
+	}
+}
+
+uint32_t SWRasterizer::GetInterVertexIndex(PlaneID planeID, uint32_t inIndex, uint32_t outIndex)
+{
+	// grow edge table before it is more than half full
+	if ((mClipEdgeNum + 1) * 2 > mClipEdgeCapacity) {
+		ResizeClipEdges(mClipEdgeCapacity * 2);
+	}
+
+	// edge is always (in, out) on plane, so triangles sharing the edge find same vertex
+	uint32_t mask = mClipEdgeCapacity - 1;
+	uint32_t slot = HashClipEdge(inIndex, outIndex, planeID) & mask;
+	while (mClipEdges[slot].vertexIndex != EMPTY_CLIP_EDGE) {
+		const ClipEdge& edge = mClipEdges[slot];
+		if (edge.inIndex == inIndex && edge.outIndex == outIndex && edge.planeID == planeID) {
+			return edge.vertexIndex;
+		}
+
+		slot = (slot + 1) & mask;
+	}
+
+	// copy vertices before adding, adding can reallocate list
+	Vertex inV = GetVertex(inIndex);
+	Vertex outV = GetVertex(outIndex);
+	uint32_t vertexIndex = GetVertexNum();
+	mClipVertices->Add<Vertex>(CalculateInterVertex(planeID, inV, outV));
+
+	mClipEdges[slot] = { inIndex, outIndex, planeID, vertexIndex };
+	mClipEdgeNum++;
+
+	return vertexIndex;
+}
+
+void SWRasterizer::ResetClipEdges()
+{
+	if (mClipEdgeNum == 0) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < mClipEdgeCapacity; i++) {
+		mClipEdges[i].vertexIndex = EMPTY_CLIP_EDGE;
+	}
+	mClipEdgeNum = 0;
+}
+
+void SWRasterizer::ResizeClipEdges(uint32_t capacity)
+{
+	ClipEdge* oldEdges = mClipEdges;
+	uint32_t oldCapacity = mClipEdgeCapacity;
+
+	mClipEdges = new ClipEdge[capacity];
+	mClipEdgeCapacity = capacity;
+	for (uint32_t i = 0; i < capacity; i++) {
+		mClipEdges[i].vertexIndex = EMPTY_CLIP_EDGE;
+	}
+
+	// rehash
+	uint32_t mask = capacity - 1;
+	for (uint32_t i = 0; i < oldCapacity; i++) {
+		if (oldEdges[i].vertexIndex == EMPTY_CLIP_EDGE) {
+			continue;
+		}
+
+		uint32_t slot = HashClipEdge(oldEdges[i].inIndex, oldEdges[i].outIndex, oldEdges[i].planeID) & mask;
+		while (mClipEdges[slot].vertexIndex != EMPTY_CLIP_EDGE) {
+			slot = (slot + 1) & mask;
+		}
+		mClipEdges[slot] = oldEdges[i];
+	}
+
+	if (oldEdges != nullptr) {
+		delete[] oldEdges;
 	}
-	// set index & vertex num
-	*pClippedVertexNum = vertexNum;
-	*pClippedIndexNum = (vertexNum - 2) * 3;
 }
 
 inline bool SWRasterizer::IsInPlane(PlaneID planeID, const Vertex& clipVertex)
 {
 	switch (planeID) {
+		// -x, +x, -y, +y planes are guard band
 		// -x
 		case PlaneID::NegX:
-			return clipVertex.pos.x >= -clipVertex.pos.w;
+			return clipVertex.pos.x >= mGuardBandMinX * clipVertex.pos.w;
 			// +x
 		case PlaneID::PosX:
-			return clipVertex.pos.x <= clipVertex.pos.w;
+			return clipVertex.pos.x <= mGuardBandMaxX * clipVertex.pos.w;
 			// -y
 		case PlaneID::NegY:
-			return clipVertex.pos.y >= -clipVertex.pos.w;
+			return clipVertex.pos.y >= mGuardBandMinY * clipVertex.pos.w;
 			// +y
 		case PlaneID::PosY:
-			return clipVertex.pos.y <= clipVertex.pos.w;
+			return clipVertex.pos.y <= mGuardBandMaxY * clipVertex.pos.w;
 			// -z
 		case PlaneID::NegZ:
 			return clipVertex.pos.z >= 0;
@@ -328,16 +724,16 @@ inline float SWRasterizer::GetSignedDstWithPlane(PlaneID planeID, const Vertex&
 	switch (planeID) {
 		// -x
 		case PlaneID::NegX:
-			return clipVertex.pos.x + clipVertex.pos.w;
+			return clipVertex.pos.x - mGuardBandMinX * clipVertex.pos.w;
 			// +x
 		case PlaneID::PosX:
-			return clipVertex.pos.x - clipVertex.pos.w;
+			return clipVertex.pos.x - mGuardBandMaxX * clipVertex.pos.w;
 			// -y
 		case PlaneID::NegY:
-			return clipVertex.pos.y + clipVertex.pos.w;
+			return clipVertex.pos.y - mGuardBandMinY * clipVertex.pos.w;
 			// +y
 		case PlaneID::PosY:
-			return clipVertex.pos.y - clipVertex.pos.w;
+			return clipVertex.pos.y - mGuardBandMaxY * clipVertex.pos.w;
 			// -z
 		case PlaneID::NegZ:
 			return clipVertex.pos.z;
@@ -356,639 +752,247 @@ inline Vertex SWRasterizer::CalculateInterVertex(PlaneID planeID, const Vertex&
 	float v0Dst = GetSignedDstWithPlane(planeID, inV);
 	float v1Dst = GetSignedDstWithPlane(planeID, outV);
 	float t = v0Dst / (v0Dst - v1Dst);
-	// TODO : add attribute interpolation
 	Vertex interV;
 	interV.pos = Vec4::Lerp(inV.pos, outV.pos, t);
+	// varyings are linear in clip space
+	for (uint32_t i = 0; i < mVaryingNum; i++) {
+		interV.varyings[i] = inV.varyings[i] + (outV.varyings[i] - inV.varyings[i]) * t;
+	}
 
 	return interV;	
 }
 
-void SWRasterizer::DividePerspective(List** pVertices)
+void SWRasterizer::CullBackFace(List** pCulledIndices, List** pCulledMaterialIDs, const ArrayView<uint32_t>& indices, const uint32_t* materialIDs)
 {
-	for (int i = 0; i < (*pVertices)->GetSize(); i++) {
-		float w = (*pVertices)->At<Vertex>(i).pos.w;
-		if ((*reinterpret_cast<int32_t*>(&w) & 0) == 0) {
-			// TODO : add min fraction value that be kept when convert fixed point
-			// TODO : thinking how impact error cuz of adding this constant.
-			//			and interpolation if able
-			w += HOMOGENEOUS_VERTEX_MIN_Z;
+	// determinant of rows (x, y, w) is w1 * w2 * w3 * (z of ndc (v2 - v1) x (v3 - v1)),
+	// so its sign gives orientation of triangle without perspective division, even when w is negative.
+	//		when cw, it is less than 0
+	uint32_t triangleNum = indices.num / 3;
+	(*pCulledIndices)->Resize(triangleNum * 3);
+	uint32_t* outIndices = (*pCulledIndices)->GetData<uint32_t>();
+	const uint32_t* inMaterialIDs = materialIDs;
+	uint32_t* outMaterialIDs = nullptr;
+	if (pCulledMaterialIDs != nullptr) {
+		(*pCulledMaterialIDs)->Resize(triangleNum);
+		outMaterialIDs = (*pCulledMaterialIDs)->GetData<uint32_t>();
+	}
+
+	// 4 triangles at once. indices of every triangle are written,
+	// but write position goes forward only when triangle remains
+	uint32_t culledTriangleNum = 0;
+	uint32_t triangleIdx = 0;
+	for (; triangleIdx + 4 <= triangleNum; triangleIdx += 4) {
+		uint32_t tri[12];
+		for (uint32_t i = 0; i < 12; i++) {
+			tri[i] = indices[triangleIdx * 3 + i];
 		}
+		const Vec4& a1 = mInputVertices[tri[0]].pos;
+		const Vec4& a2 = mInputVertices[tri[1]].pos;
+		const Vec4& a3 = mInputVertices[tri[2]].pos;
+		const Vec4& b1 = mInputVertices[tri[3]].pos;
+		const Vec4& b2 = mInputVertices[tri[4]].pos;
+		const Vec4& b3 = mInputVertices[tri[5]].pos;
+		const Vec4& c1 = mInputVertices[tri[6]].pos;
+		const Vec4& c2 = mInputVertices[tri[7]].pos;
+		const Vec4& c3 = mInputVertices[tri[8]].pos;
+		const Vec4& d1 = mInputVertices[tri[9]].pos;
+		const Vec4& d2 = mInputVertices[tri[10]].pos;
+		const Vec4& d3 = mInputVertices[tri[11]].pos;
+
+		__m128 x1 = _mm_setr_ps(a1.x, b1.x, c1.x, d1.x);
+		__m128 y1 = _mm_setr_ps(a1.y, b1.y, c1.y, d1.y);
+		__m128 w1 = _mm_setr_ps(a1.w, b1.w, c1.w, d1.w);
+		__m128 x2 = _mm_setr_ps(a2.x, b2.x, c2.x, d2.x);
+		__m128 y2 = _mm_setr_ps(a2.y, b2.y, c2.y, d2.y);
+		__m128 w2 = _mm_setr_ps(a2.w, b2.w, c2.w, d2.w);
+		__m128 x3 = _mm_setr_ps(a3.x, b3.x, c3.x, d3.x);
+		__m128 y3 = _mm_setr_ps(a3.y, b3.y, c3.y, d3.y);
+		__m128 w3 = _mm_setr_ps(a3.w, b3.w, c3.w, d3.w);
+
+		__m128 det = _mm_add_ps(
+			_mm_sub_ps(
+				_mm_mul_ps(x1, _mm_sub_ps(_mm_mul_ps(y2, w3), _mm_mul_ps(w2, y3))),
+				_mm_mul_ps(y1, _mm_sub_ps(_mm_mul_ps(x2, w3), _mm_mul_ps(w2, x3)))),
+			_mm_mul_ps(w1, _mm_sub_ps(_mm_mul_ps(x2, y3), _mm_mul_ps(y2, x3))));
+		uint32_t remainMask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(det, _mm_setzero_ps())));
+
+		for (uint32_t lane = 0; lane < 4; lane++) {
+			uint32_t* out = outIndices + culledTriangleNum * 3;
+			out[0] = tri[lane * 3];
+			out[1] = tri[lane * 3 + 1];
+			out[2] = tri[lane * 3 + 2];
+			if (outMaterialIDs != nullptr) {
+				outMaterialIDs[culledTriangleNum] = inMaterialIDs[triangleIdx + lane];
+			}
+			culledTriangleNum += (remainMask >> lane) & 1;
+		}
+	}
 
-		Vec4 dividedPos = (*pVertices)->At<Vertex>(i).pos;
-		dividedPos.x /= w;
-		dividedPos.y /= w;
-		dividedPos.z /= w;
+	// remain triangles
+	for (; triangleIdx < triangleNum; triangleIdx++) {
+		const uint32_t tri[3] = { indices[triangleIdx * 3], indices[triangleIdx * 3 + 1], indices[triangleIdx * 3 + 2] };
+		const Vec4& p1 = mInputVertices[tri[0]].pos;
+		const Vec4& p2 = mInputVertices[tri[1]].pos;
+		const Vec4& p3 = mInputVertices[tri[2]].pos;
 
-		(*pVertices)->At<Vertex>(i).pos = dividedPos;
-	}
-}
+		float det = p1.x * (p2.y * p3.w - p2.w * p3.y)
+			- p1.y * (p2.x * p3.w - p2.w * p3.x)
+			+ p1.w * (p2.x * p3.y - p2.y * p3.x);
 
-void SWRasterizer::CullBackFace(List** pCulledIndices, const List* indices, const List* vertices)
-{
-	for (int i = 0; i < indices->GetSize(); i += 3) {
-		Vertex v1 = vertices->At<Vertex>(indices->At<uint32_t>(i));
-		Vertex v2 = vertices->At<Vertex>(indices->At<uint32_t>(i + 1));
-		Vertex v3 = vertices->At<Vertex>(indices->At<uint32_t>(i + 2));
-
-		Vec4 dif1 = v2.pos - v1.pos;
-		Vec4 dif2 = v3.pos - v1.pos;
-
-		// z of (dif1.xy, 0) x (dif2.xy, 0)
-		float d = dif1.x* dif2.y - dif2.x * dif1.y;
-		// when cw, d is less than 0
-		if (d >= 0) {
-			continue;
+		uint32_t* out = outIndices + culledTriangleNum * 3;
+		out[0] = tri[0];
+		out[1] = tri[1];
+		out[2] = tri[2];
+		if (outMaterialIDs != nullptr) {
+			outMaterialIDs[culledTriangleNum] = inMaterialIDs[triangleIdx];
 		}
-
-		(*pCulledIndices)->Add<uint32_t>(indices->At<uint32_t>(i));
-		(*pCulledIndices)->Add<uint32_t>(indices->At<uint32_t>(i+1));
-		(*pCulledIndices)->Add<uint32_t>(indices->At<uint32_t>(i+2));
+		culledTriangleNum += det < 0.0f ? 1 : 0;
 	}
-}
 
-void SWRasterizer::TransformViewport(List** pVertices)
-{
-	// ndc to viewport	
-	//		viewport : +x : right, +y : down. origin is left top 
-	for (uint32_t i = 0; i < (*pVertices)->GetSize(); i++) {
-		Vec4 pos = (*pVertices)->At<Vertex>(i).pos;
-		pos.x = (pos.x + 1) * 0.5f * mViewport.width + mViewport.leftX;
-		pos.y = (1 - pos.y) * 0.5f * mViewport.height + mViewport.topY;
-		pos.z = pos.z * (mViewport.maxZ - mViewport.minZ) + mViewport.minZ;
-
-		(*pVertices)->At<Vertex>(i).pos = pos;
-	}	
-}
-
-void SWRasterizer::ConvertFixedPoint(List** pOutVertices, const List* vertices)
-{
-	for (uint32_t i = 0; i < vertices->GetSize(); i++) {
-		(*pOutVertices)->Add(FixedVertex(vertices->At<Vertex>(i).pos));
+	(*pCulledIndices)->Resize(culledTriangleNum * 3);
+	if (pCulledMaterialIDs != nullptr) {
+		(*pCulledMaterialIDs)->Resize(culledTriangleNum);
 	}
 }
 
-// todo : save is left, top line each triangle
-// todo : left, top  ̸ ؼ  
-void SWRasterizer::RasterizeFixedPoint(const List* fixedVertices, const List* indices)
+void SWRasterizer::CompactVertices(List** pIndices)
 {
-	const static FP halfOne = FP(0.5f);
-	const static FP one = FP(1.0f);
-	const static FP four = FP(4.0f);
-	const static FP eight = FP(8.0f);
-	for (uint32_t indexIdx = 0; indexIdx < indices->GetSize(); indexIdx += 3) {
-		const FixedVertex& v0 = fixedVertices->At<FixedVertex>(indices->At<uint32_t>(indexIdx));
-		const FixedVertex& v1 = fixedVertices->At<FixedVertex>(indices->At<uint32_t>(indexIdx + 1));
-		const FixedVertex& v2 = fixedVertices->At<FixedVertex>(indices->At<uint32_t>(indexIdx + 2));
-
-		// calculate bbox of pixel covers triangle
-		mMinX = min(v0.pos.x, min(v1.pos.x, v2.pos.x));
-		mMaxX = max(v0.pos.x, max(v1.pos.x, v2.pos.x));
-		mMinY = min(v0.pos.y, min(v1.pos.y, v2.pos.y));
-		mMaxY = max(v0.pos.y, max(v1.pos.y, v2.pos.y));
-
-		// conversion of common number from floating number to fixed number
-		FP minXFloor = mMinX.Floor();
-		FP minYFloor = mMinY.Floor();
-		FP startX = mMinX - minXFloor > halfOne ? minXFloor + one + halfOne : minXFloor + halfOne;
-		FP startY = mMinY - minYFloor > halfOne ? minYFloor + one + halfOne : minYFloor + halfOne;
-		FixedVec4 startPos(startX, startY, 0, 0);
-
-		// pre calculate 2 * triangle size
-		mTriSizeMul2 = EdgeFunctionFixedPoint(v0.pos, v1.pos, v2.pos);
-		//		because of precision of fixed point, 
-		//		difference positions of vertices before conversion of fixed point can be same after it.
-		if (mTriSizeMul2 == 0) {
-			continue;
-		}
-
-		// fixed number & partition rasterization
-#if RASTERIZATION_TYPE == PARTITION_RASTERIZATION
-		// pre calculate difference of edge value by 2^i x, 2^i y				
-		mDxEdge01s[0] = (v1.pos.y - v0.pos.y).ToDoubleFixedPoint();
-		mDxEdge12s[0] = (v2.pos.y - v1.pos.y).ToDoubleFixedPoint();
-		mDxEdge20s[0] = (v0.pos.y - v2.pos.y).ToDoubleFixedPoint();
-		mDyEdge01s[0] = (v0.pos.x - v1.pos.x).ToDoubleFixedPoint();
-		mDyEdge12s[0] = (v1.pos.x - v2.pos.x).ToDoubleFixedPoint();
-		mDyEdge20s[0] = (v2.pos.x - v0.pos.x).ToDoubleFixedPoint();
-
-		DF startEdge01 = EdgeFunctionFixedPoint(startPos, v0.pos, v1.pos);
-		DF startEdge12 = EdgeFunctionFixedPoint(startPos, v1.pos, v2.pos);
-		DF startEdge20 = EdgeFunctionFixedPoint(startPos, v2.pos, v0.pos);
-
-#pragma UNROLL(3)
-		for (int i = 1; i <= 3; i++) {
-			mDxEdge01s[i] = mDxEdge01s[0] * (1 << i); // (2^i)			
-			mDxEdge12s[i] = mDxEdge12s[0] * (1 << i);
-			mDxEdge20s[i] = mDxEdge20s[0] * (1 << i);
-
-
-			mDyEdge01s[i] = mDyEdge01s[0] * (1 << i);
-			mDyEdge12s[i] = mDyEdge12s[0] * (1 << i);
-			mDyEdge20s[i] = mDyEdge20s[0] * (1 << i);
-		}
-
-		// rasterize bunch of pixels starts with 8*8 pixels
-		DF yEdge01 = startEdge01;
-		DF yEdge12 = startEdge12;
-		DF yEdge20 = startEdge20;
-		for (FP y = startY; y <= mMaxY; y += eight) {
-
-			DF xEdge01 = yEdge01;
-			DF xEdge12 = yEdge12;
-			DF xEdge20 = yEdge20;
-			for (FP x = startX; x <= mMaxX; x += eight) {
-				RasterizePartFixedPoint(v0.pos, v1.pos, v2.pos, x, y, 3, xEdge01, xEdge12, xEdge20);
-
-				xEdge01 += mDxEdge01s[3];
-				xEdge12 += mDxEdge12s[3];
-				xEdge20 += mDxEdge20s[3];
-			}
-
-			yEdge01 += mDyEdge01s[3];
-			yEdge12 += mDyEdge12s[3];
-			yEdge20 += mDyEdge20s[3];
-
-		}
-#elif RASTERIZATION_TYPE == ADVANCED_RASTERIZATION
-		mDxEdge01s[0] = (v1.pos.y - v0.pos.y).ToDoubleFixedPoint();
-		mDxEdge12s[0] = (v2.pos.y - v1.pos.y).ToDoubleFixedPoint();
-		mDxEdge20s[0] = (v0.pos.y - v2.pos.y).ToDoubleFixedPoint();
-		mDyEdge01s[0] = (v0.pos.x - v1.pos.x).ToDoubleFixedPoint();
-		mDyEdge12s[0] = (v1.pos.x - v2.pos.x).ToDoubleFixedPoint();
-		mDyEdge20s[0] = (v2.pos.x - v0.pos.x).ToDoubleFixedPoint();
-
-		DF yEdge01 = EdgeFunctionFixedPoint(startPos, v0.pos, v1.pos);
-		DF yEdge12 = EdgeFunctionFixedPoint(startPos, v1.pos, v2.pos);
-		DF yEdge20 = EdgeFunctionFixedPoint(startPos, v2.pos, v0.pos);
-		for (FP y = startY;
-			y <= mMaxY;
-			y += one,
-			yEdge01 += mDyEdge01s[0],
-			yEdge12 += mDyEdge12s[0],
-			yEdge20 += mDyEdge20s[0])
-		{
-			DF xEdge01 = yEdge01;
-			DF xEdge12 = yEdge12;
-			DF xEdge20 = yEdge20;
-
-			for (FP x = startX; 
-				x <= mMaxX;
-				x += one,
-				xEdge01 += mDxEdge01s[0],
-				xEdge12 += mDxEdge12s[0],
-				xEdge20 += mDxEdge20s[0]) 
-			{
-				FixedVec4 pixelPos(x, y, FP::ZERO, FP::ZERO);
-				DF edge01 = EdgeFunctionFixedPoint(pixelPos, v0.pos, v1.pos);
-				DF edge12 = EdgeFunctionFixedPoint(pixelPos, v1.pos, v2.pos);
-				DF edge20 = EdgeFunctionFixedPoint(pixelPos, v2.pos, v0.pos);
-
-				//TODO :  if ȭ
-				if (edge01 > DF::ZERO
-					|| edge12 > DF::ZERO
-					|| edge20 > DF::ZERO) {
-					continue;
-				}
-
-				if (edge01 == DF::ZERO
-					&& !IsLeftLineFixedPoint(v0.pos, v1.pos)
-					&& !IsTopLineFixedPoint(v0.pos, v1.pos)) {
-					continue;
-				}
-
-				if (edge12 == DF::ZERO
-					&& !IsLeftLineFixedPoint(v1.pos, v2.pos)
-					&& !IsTopLineFixedPoint(v1.pos, v2.pos)) {
-					continue;
-				}
-
-				if (edge20 == DF::ZERO
-					&& !IsLeftLineFixedPoint(v2.pos, v0.pos)
-					&& !IsTopLineFixedPoint(v2.pos, v0.pos)) {
-					continue;
-				}
-
-				DF bary01 = edge01 / mTriSizeMul2;
-				DF bary12 = edge12 / mTriSizeMul2;
-				DF bary20 = edge20 / mTriSizeMul2;
-
-				Vec4 pos = Vec4::ZERO;
-				pos.x = x.ToFloat();
-				pos.y = y.ToFloat();
-				pos.w = bary12.ToDouble() / v0.pos.w.ToFloat()
-					+ bary20.ToDouble() / v1.pos.w.ToFloat()
-					+ bary01.ToDouble() / v2.pos.w.ToFloat();
-				pos.z = 1.0f / pos.w;
-
-				Pixel pixel;
-				pixel.pos = pos;
-				mPixels->Add(pixel);
+	// new index of each vertex. EMPTY_VERTEX_INDEX until it is referenced
+	uint64_t vertexNum = GetVertexNum();
+	mVertexRemap->Resize(vertexNum);
+	uint32_t* remap = mVertexRemap->GetData<uint32_t>();
+	memset(remap, 0xFF, vertexNum * sizeof(uint32_t));
+
+	for (int c = 0; c < 4; c++) {
+		mPositionStreams[c]->Reset(sizeof(float));
+	}
+	mVaryingStream->Reset(sizeof(float));
+
+	uint64_t indexNum = (*pIndices)->GetSize();
+	for (uint64_t i = 0; i < indexNum; i++) {
+		uint32_t& index = (*pIndices)->At<uint32_t>(i);
+		if (remap[index] == EMPTY_VERTEX_INDEX) {
+			const Vertex& vertex = GetVertex(index);
+			remap[index] = static_cast<uint32_t>(mPositionStreams[0]->GetSize());
+			mPositionStreams[0]->Add<float>(vertex.pos.x);
+			mPositionStreams[1]->Add<float>(vertex.pos.y);
+			mPositionStreams[2]->Add<float>(vertex.pos.z);
+			mPositionStreams[3]->Add<float>(vertex.pos.w);
+			if (mVaryingNum > 0) {
+				mVaryingStream->Add<float>(vertex.varyings, mVaryingNum);
 			}
-			
 		}
 
-		// fixed number & normal rasterization
-#else
-		for (FP y = startY; y <= mMaxY; y += one) {
-			for (FP x = startX; x <= mMaxX; x += one) {
-				FixedVec4 pixelPos(x, y, FP::ZERO, FP::ZERO);
-				DF edge01 = EdgeFunctionFixedPoint(pixelPos, v0.pos, v1.pos);
-				DF edge12 = EdgeFunctionFixedPoint(pixelPos, v1.pos, v2.pos);
-				DF edge20 = EdgeFunctionFixedPoint(pixelPos, v2.pos, v0.pos);
-
-				//TODO :  if ȭ
-				if (edge01 > DF::ZERO
-					|| edge12 > DF::ZERO
-					|| edge20 > DF::ZERO) {
-					continue;
-				}
-
-				if (edge01 == DF::ZERO
-					&& !IsLeftLineFixedPoint(v0.pos, v1.pos)
-					&& !IsTopLineFixedPoint(v0.pos, v1.pos)) {
-					continue;
-				}
-
-				if (edge12 == DF::ZERO
-					&& !IsLeftLineFixedPoint(v1.pos, v2.pos)
-					&& !IsTopLineFixedPoint(v1.pos, v2.pos)) {
-					continue;
-				}
-
-				if (edge20 == DF::ZERO
-					&& !IsLeftLineFixedPoint(v2.pos, v0.pos)
-					&& !IsTopLineFixedPoint(v2.pos, v0.pos)) {
-					continue;
-				}
-
-				DF bary01 = edge01 / mTriSizeMul2;
-				DF bary12 = edge12 / mTriSizeMul2;
-				DF bary20 = edge20 / mTriSizeMul2;
-
-				Vec4 pos = Vec4::ZERO;
-				pos.x = x.ToFloat();
-				pos.y = y.ToFloat();
-				pos.w = bary12.ToDouble() / v0.pos.w.ToFloat()
-					+ bary20.ToDouble() / v1.pos.w.ToFloat()
-					+ bary01.ToDouble() / v2.pos.w.ToFloat();
-				pos.z = 1.0f / pos.w;
-
-				Pixel pixel;
-				pixel.pos = pos;
-				mPixels->Add(pixel);
-			}
-		}
-#endif
+		index = remap[index];
 	}
 }
 
-void SWRasterizer::RasterizeFloatingPoint(const List* floatingVertices, const List* indices)
+void SWRasterizer::TransformVertices(List** pViewportVertices, List** pFixedVertices)
 {
-	uint64_t indexLen = indices->GetSize();
-	for (int indexIdx = 0; indexIdx < indexLen; indexIdx+=3) {
-		Vertex v0 = floatingVertices->At<Vertex>(indices->At<uint32_t>(indexIdx));
-		Vertex v1 = floatingVertices->At<Vertex>(indices->At<uint32_t>(indexIdx + 1));
-		Vertex v2 = floatingVertices->At<Vertex>(indices->At<uint32_t>(indexIdx + 2));
-
-		// calculate bbox covers triangle
-		float minX = min(v0.pos.x, min(v1.pos.x, v2.pos.x));
-		float maxX = max(v0.pos.x, max(v1.pos.x, v2.pos.x));
-		float minY = min(v0.pos.y, min(v1.pos.y, v2.pos.y));
-		float maxY = max(v0.pos.y, max(v1.pos.y, v2.pos.y));
-
-		float minXFloor = floor(minX);
-		float minYFloor = floor(minY);
-		float startX = minX - minXFloor > 0.5f ? minXFloor + 1.5f : minXFloor + 0.5f;
-		float startY = minY - minYFloor > 0.5f ? minYFloor + 1.5f : minYFloor + 0.5f;
-
-		float triSizeMul2 = (v2.pos.x - v0.pos.x) * (v1.pos.y - v0.pos.y) - (v2.pos.y - v0.pos.y) * (v1.pos.x - v0.pos.x);
-
-#if RASTERIZATION_TYPE == NORMAL_RASTERIZATION
-		for (float y = startY; y <= mMaxY; y += 1.0f) {
-			for (float x = startX; x <= mMaxX; x += 1.0f) {
-				float edge01 = (x - v0.pos.x) * (v1.pos.y - v0.pos.y) - (y - v0.pos.y) * (v1.pos.x - v0.pos.x);
-				float edge12 = (x - v1.pos.x) * (v2.pos.y - v1.pos.y) - (y - v1.pos.y) * (v2.pos.x - v1.pos.x);
-				float edge20 = (x - v2.pos.x) * (v0.pos.y - v2.pos.y) - (y - v2.pos.y) * (v0.pos.x - v2.pos.x);				
-
-				//TODO :  if ȭ
-				if (edge01 > 0
-					|| edge12 > 0
-					|| edge20 > 0) {
-					continue;
-				}
-
-				if (edge01 == DF::ZERO
-					&& !IsLeftLineFloatingPoint(v0.pos, v1.pos)
-					&& !IsLeftLineFloatingPoint(v0.pos, v1.pos)) {
-					continue;
-				}
-
-				if (edge12 == DF::ZERO
-					&& !IsLeftLineFloatingPoint(v1.pos, v2.pos)
-					&& !IsLeftLineFloatingPoint(v1.pos, v2.pos)) {
-					continue;
-				}
-
-				if (edge20 == DF::ZERO
-					&& !IsLeftLineFloatingPoint(v2.pos, v0.pos)
-					&& !IsLeftLineFloatingPoint(v2.pos, v0.pos)) {
-					continue;
-				}
-
-				float bary01 = edge01 / triSizeMul2;
-				float bary12 = edge12 / triSizeMul2;
-				float bary20 = edge20 / triSizeMul2;
-
-				Vec4 pos = Vec4::ZERO;
-				pos.x = x;
-				pos.y = y;
-				pos.w = bary12 / v0.pos.w
-					+ bary20 / v1.pos.w
-					+ bary01 / v2.pos.w;
-				pos.z = 1.0f / pos.w;
-
-				Pixel pixel;
-				pixel.pos = pos;
-				mPixels->Add(pixel);
-			}
+	// ndc to viewport	
+	//		viewport : +x : right, +y : down. origin is left top 
+	//		x = (x / w + 1) * 0.5 * width + leftX
+	//		y = (1 - y / w) * 0.5 * height + topY
+	//		z = z / w * (maxZ - minZ) + minZ
+	//		w is kept for perspective correct interpolation
+	const float halfWidth = 0.5f * mViewport.width;
+	const float halfHeight = 0.5f * mViewport.height;
+	const float depthRange = mViewport.maxZ - mViewport.minZ;
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 minW = _mm_set1_ps(HOMOGENEOUS_VERTEX_MIN_Z);
+	const __m128 halfWidths = _mm_set1_ps(halfWidth);
+	const __m128 halfHeights = _mm_set1_ps(halfHeight);
+	const __m128 leftXs = _mm_set1_ps(static_cast<float>(mViewport.leftX));
+	const __m128 topYs = _mm_set1_ps(static_cast<float>(mViewport.topY));
+	const __m128 depthRanges = _mm_set1_ps(depthRange);
+	const __m128 minZs = _mm_set1_ps(mViewport.minZ);
+	const __m128 fixedScale = _mm_set1_ps(static_cast<float>(1 << FP::FRAC_BITS_LEN));
+
+	uint32_t vertexNum = static_cast<uint32_t>(mPositionStreams[0]->GetSize());
+	const float* xs = mPositionStreams[0]->GetData<float>();
+	const float* ys = mPositionStreams[1]->GetData<float>();
+	const float* zs = mPositionStreams[2]->GetData<float>();
+	const float* ws = mPositionStreams[3]->GetData<float>();
+
+	(*pViewportVertices)->Resize(vertexNum);
+	Vertex* outVertices = (*pViewportVertices)->GetData<Vertex>();
+	FixedVertex* outFixedVertices = nullptr;
+	if (pFixedVertices) {
+		(*pFixedVertices)->Resize(vertexNum);
+		outFixedVertices = (*pFixedVertices)->GetData<FixedVertex>();
+	}
+
+	// 4 vertices at once
+	uint32_t i = 0;
+	for (; i + 4 <= vertexNum; i += 4) {
+		__m128 x = _mm_loadu_ps(xs + i);
+		__m128 y = _mm_loadu_ps(ys + i);
+		__m128 z = _mm_loadu_ps(zs + i);
+		__m128 w = _mm_loadu_ps(ws + i);
+
+		// TODO : add min fraction value that be kept when convert fixed point
+		__m128 invW = _mm_div_ps(one, _mm_add_ps(w, minW));
+
+		x = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(x, invW), one), halfWidths), leftXs);
+		y = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(y, invW)), halfHeights), topYs);
+		z = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(z, invW), depthRanges), minZs);
+
+		// AoS for rasterizer
+		__m128 row0 = x;
+		__m128 row1 = y;
+		__m128 row2 = z;
+		__m128 row3 = w;
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+		_mm_storeu_ps(&outVertices[i].pos.x, row0);
+		_mm_storeu_ps(&outVertices[i + 1].pos.x, row1);
+		_mm_storeu_ps(&outVertices[i + 2].pos.x, row2);
+		_mm_storeu_ps(&outVertices[i + 3].pos.x, row3);
+
+		if (outFixedVertices == nullptr) {
+			continue;
 		}
 
-#elif RATSERIZATION_TYPE == PARTITION_RASTERIZATION
-#elif RASTERIZATION_TYPE == ADVANCED_RASTERIZATION
-#endif
-
+		// same truncation with FP(float)
+		alignas(16) int32_t raws[4][4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(raws[0]), _mm_cvttps_epi32(_mm_mul_ps(x, fixedScale)));
+		_mm_store_si128(reinterpret_cast<__m128i*>(raws[1]), _mm_cvttps_epi32(_mm_mul_ps(y, fixedScale)));
+		_mm_store_si128(reinterpret_cast<__m128i*>(raws[2]), _mm_cvttps_epi32(_mm_mul_ps(z, fixedScale)));
+		_mm_store_si128(reinterpret_cast<__m128i*>(raws[3]), _mm_cvttps_epi32(_mm_mul_ps(w, fixedScale)));
+		for (uint32_t lane = 0; lane < 4; lane++) {
+			FixedVec4& pos = outFixedVertices[i + lane].pos;
+			pos.x.raw = raws[0][lane];
+			pos.y.raw = raws[1][lane];
+			pos.z.raw = raws[2][lane];
+			pos.w.raw = raws[3][lane];
+		}
 	}
-}
 
+	// remain vertices
+	for (; i < vertexNum; i++) {
+		float invW = 1.0f / (ws[i] + HOMOGENEOUS_VERTEX_MIN_Z);
 
-void SWRasterizer::RasterizePartFixedPoint(
-	const FixedVec4& v0Pos,
-	const FixedVec4& v1Pos,
-	const FixedVec4& v2Pos,
-	FP leftX,
-	FP topY,
-	uint8_t pixelLengthLog2,
-	DF edge01,
-	DF edge12,
-	DF edge20)
-{
-	// pixel length = 1
-	if (pixelLengthLog2 == 0) {
-		AddPixelIsInTriangleFixedPoint(v0Pos, v1Pos, v2Pos, leftX, topY, edge01, edge12, edge20);
-		return;
-	}
-	// pixel length 2
-	else if (pixelLengthLog2 == 1) {
-		AddPixelIsInTriangleFixedPoint(v0Pos, v1Pos, v2Pos, leftX, topY,
-			edge01, edge12, edge20);
-		AddPixelIsInTriangleFixedPoint(v0Pos, v1Pos, v2Pos, leftX + 1, topY,
-			edge01 + mDxEdge01s[0],
-			edge12 + mDxEdge12s[0],
-			edge20 + mDxEdge20s[0]);
-		AddPixelIsInTriangleFixedPoint(v0Pos, v1Pos, v2Pos, leftX, topY + 1,
-			edge01 + mDyEdge01s[0],
-			edge12 + mDyEdge12s[0],
-			edge20 + mDyEdge20s[0]);
-		AddPixelIsInTriangleFixedPoint(v0Pos, v1Pos, v2Pos, leftX + 1, topY + 1,
-			edge01 + mDxEdge01s[0] + mDyEdge01s[0],
-			edge12 + mDxEdge12s[0] + mDyEdge12s[0],
-			edge20 + mDxEdge20s[0] + mDyEdge20s[0]);
+		Vec4 pos(
+			(xs[i] * invW + 1.0f) * halfWidth + mViewport.leftX,
+			(1.0f - ys[i] * invW) * halfHeight + mViewport.topY,
+			zs[i] * invW * depthRange + mViewport.minZ,
+			ws[i]);
+		outVertices[i].pos = pos;
 
-		return;
-	}
-
-	// TODO : test advancing bary method
-	//			remove
-	//DF a = EdgeFunction(FixedVec4(leftX, topY, 0, 1), v0Pos, v1Pos);
-	//DF b = EdgeFunction(FixedVec4(leftX, topY, 0, 1), v1Pos, v2Pos);
-	//DF c = EdgeFunction(FixedVec4(leftX, topY, 0, 1), v2Pos, v0Pos);
-	//DF s = EdgeFunction(v0Pos, v1Pos, v2Pos);
-	//if (abs((a / s).ToDouble() - bary01.ToFloat()) > 0.01f
-	//	|| abs((b / s).ToDouble() - bary12.ToFloat()) > 0.01f
-	//	|| abs((c / s).ToDouble() - bary20.ToFloat()) > 0.01f) {
-	//	SetConsoleActiveScreenBuffer(GetStdHandle(STD_OUTPUT_HANDLE));
-	//	std::cout << "dif 01 : " << (a / s).ToDouble() << " " << bary01.ToFloat() << std::endl;
-	//	std::cout << "dif 12 : " << (b / s).ToDouble() << " " << bary12.ToFloat() << std::endl;
-	//	std::cout << "dif 20 : " << (c / s).ToDouble() << " " << bary20.ToFloat() << std::endl;
-	//	__debugbreak();
-	//}
-
-
-	// four corners don't inside triangle, divide pixel sqaure finely
-	DF rightTopEdge01 = edge01 + (mDxEdge01s[pixelLengthLog2] - mDxEdge01s[0]);
-	DF rightTopEdge12 = edge12 + (mDxEdge12s[pixelLengthLog2] - mDxEdge12s[0]);
-	DF rightTopEdge20 = edge20 + (mDxEdge20s[pixelLengthLog2] - mDxEdge20s[0]);
-
-	DF leftBottomEdge01 = edge01 + (mDyEdge01s[pixelLengthLog2] - mDyEdge01s[0]);
-	DF leftBottomEdge12 = edge12 + (mDyEdge12s[pixelLengthLog2] - mDyEdge12s[0]);
-	DF leftBottomEdge20 = edge20 + (mDyEdge20s[pixelLengthLog2] - mDyEdge20s[0]);
-
-	DF rightBottomEdge01 = edge01 + (mDxEdge01s[pixelLengthLog2] - mDxEdge01s[0]) + (mDyEdge01s[pixelLengthLog2] - mDyEdge01s[0]);
-	DF rightBottomEdge12 = edge12 + (mDxEdge12s[pixelLengthLog2] - mDxEdge12s[0]) + (mDyEdge12s[pixelLengthLog2] - mDyEdge12s[0]);
-	DF rightBottomEdge20 = edge20 + (mDxEdge20s[pixelLengthLog2] - mDxEdge20s[0]) + (mDyEdge20s[pixelLengthLog2] - mDyEdge20s[0]);
-
-	FP rightX = leftX + (1 << pixelLengthLog2) - 1;
-	FP bottomY = topY + (1 << pixelLengthLog2) - 1;
-
-	// TODO : think what is faster btw simd comp, contiguous || in if
-	bool isOutBBox = leftX < mMinX
-		|| rightX > mMaxX
-		|| topY < mMinY
-		|| bottomY > mMaxY;
-	
-	// for not thinking top-left rule in 4*4, 8*8 pixel blocks in triangle,
-	// select only pixel blocks in triangle and not on triangle sides.
-	bool isOutOrOnTriangle = edge01 >= DF::ZERO
-		|| edge12 >= DF::ZERO
-		|| edge20 >= DF::ZERO
-		|| rightTopEdge01 >= DF::ZERO
-		|| rightTopEdge12 >= DF::ZERO
-		|| rightTopEdge20 >= DF::ZERO
-		|| leftBottomEdge01 >= DF::ZERO
-		|| leftBottomEdge12 >= DF::ZERO
-		|| leftBottomEdge20 >= DF::ZERO
-		|| rightBottomEdge01 >= DF::ZERO
-		|| rightBottomEdge12 >= DF::ZERO
-		|| rightBottomEdge20 >= DF::ZERO;
-
-	if (isOutBBox || isOutOrOnTriangle) {
-		uint8_t finePixelLengthLog2 = pixelLengthLog2 - 1;
-		FP finePixelLength(1 << finePixelLengthLog2);
-
-		RasterizePartFixedPoint(v0Pos, v1Pos, v2Pos, leftX, topY, finePixelLengthLog2, 
-			edge01, edge12, edge20);
-		RasterizePartFixedPoint(v0Pos, v1Pos, v2Pos, leftX + finePixelLength, topY, finePixelLengthLog2, 
-			edge01 + mDxEdge01s[finePixelLengthLog2],
-			edge12 + mDxEdge12s[finePixelLengthLog2],
-			edge20 + mDxEdge20s[finePixelLengthLog2]);
-		RasterizePartFixedPoint(v0Pos, v1Pos, v2Pos, leftX, topY + finePixelLength, finePixelLengthLog2, 
-			edge01 + mDyEdge01s[finePixelLengthLog2],
-			edge12 + mDyEdge12s[finePixelLengthLog2],
-			edge20 + mDyEdge20s[finePixelLengthLog2]);
-		RasterizePartFixedPoint(v0Pos, v1Pos, v2Pos, leftX + finePixelLength, topY + finePixelLength, finePixelLengthLog2, 
-			edge01 + mDxEdge01s[finePixelLengthLog2] + mDyEdge01s[finePixelLengthLog2],
-			edge12 + mDxEdge12s[finePixelLengthLog2] + mDyEdge12s[finePixelLengthLog2],
-			edge20 + mDxEdge20s[finePixelLengthLog2] + mDyEdge20s[finePixelLengthLog2]);
-		return;
-	}
-
-	// add all pixels in four corners	
-	FP y = topY;
-	FP x = leftX;
-	DF yEdge01 = edge01;
-	DF yEdge12 = edge12;
-	DF yEdge20 = edge20;
-	uint8_t pixelLength = 1 << pixelLengthLog2;
-	for (uint8_t yIdx = 0; yIdx < pixelLength; yIdx++) {
-
-		DF xEdge01 = yEdge01;
-		DF xEdge12 = yEdge12;
-		DF xEdge20 = yEdge20;
-		for (uint8_t xIdx = 0; xIdx < pixelLength; xIdx++) {
-			// todo : create advanced partition rasterization in two methods
-			// 1. advanced edge differenece only pixel blocks in triangle and not on sides of triangle
-			// 2. add brances when pixel blocks include pixels on right or bottom sides of triangle
-
-			Pixel pixel;
-			pixel.pos = InterpolatePosFixedPoint(x,
-				y,
-				v0Pos,
-				v1Pos,
-				v2Pos,
-				xEdge01,
-				xEdge12,
-				xEdge20);
-			mPixels->Add(pixel);
-
-			
-			xEdge01 += mDxEdge01s[0];
-			xEdge12 += mDxEdge12s[0];
-			xEdge20 += mDxEdge20s[0];
-			x += FP::ONE;
+		if (outFixedVertices) {
+			outFixedVertices[i].pos = FixedVertex(pos).pos;
 		}
-
-		yEdge01 += mDyEdge01s[0];
-		yEdge12 += mDyEdge12s[0];
-		yEdge20 += mDyEdge20s[0];
-
-		y += FP::ONE;
-		x = leftX;
 	}
 
-}
-
-inline void SWRasterizer::AddPixelIsInTriangleFixedPoint(const FixedVec4& v0Pos, const FixedVec4& v1Pos, const FixedVec4& v2Pos, FP x, FP y, DF edge01, DF edge12, DF edge20)
-{
-	// out viewport
-	bool isOutBBox = x < mMinX
-		|| x >= mMaxX
-		|| y < mMinY
-		|| y >= mMaxY;
-	if (isOutBBox) {
+	if (mVaryingNum == 0) {
 		return;
 	}
 
-	// not in triangle
-	bool isSelect = IsSelectPixelFixedPoint(v0Pos, v1Pos, v2Pos, x, y, edge01, edge12, edge20);
-	if (isSelect == false) {
-		return;
-	}
-
-
-	Pixel pixel;
-	pixel.pos = InterpolatePosFixedPoint(x,
-		y,
-		v0Pos,
-		v1Pos,
-		v2Pos,
-		edge01,
-		edge12,
-		edge20);
-
-
-	mPixels->Add(pixel);
-}
-
-inline bool SWRasterizer::IsSelectPixelFixedPoint(const FixedVec4& v0Pos, const FixedVec4& v1Pos, const FixedVec4& v2Pos, FP x, FP y, DF edge01, DF edge12, DF edge20)
-{
-	//TODO :  if ȭ
-	if (edge01 > DF::ZERO 
-		|| edge12 > DF::ZERO 
-		|| edge20 > DF::ZERO) {
-		return false;
-	}
-
-
-	if (edge01 == DF::ZERO 
-		&& !IsLeftLineFixedPoint(v0Pos, v1Pos)
-		&& !IsTopLineFixedPoint(v0Pos, v1Pos)) {
-		return false;
-	}
-
-	if (edge12 == DF::ZERO
-		&& !IsLeftLineFixedPoint(v1Pos, v2Pos)
-		&& !IsTopLineFixedPoint(v1Pos, v2Pos)) {
-		return false;
-	}
-
-	if (edge20 == DF::ZERO
-		&& !IsLeftLineFixedPoint(v2Pos, v0Pos)
-		&& !IsTopLineFixedPoint(v2Pos, v0Pos)) {
-		return false;
+	// varyings are divided by w per pixel in rasterizer
+	const float* varyings = mVaryingStream->GetData<float>();
+	for (i = 0; i < vertexNum; i++) {
+		memcpy(outVertices[i].varyings, varyings + i * mVaryingNum, mVaryingNum * sizeof(float));
+		if (outFixedVertices) {
+			memcpy(outFixedVertices[i].varyings, varyings + i * mVaryingNum, mVaryingNum * sizeof(float));
+		}
 	}
-
-	return true;
-}
-
-
-
-inline bool SWRasterizer::IsLeftLineFixedPoint(const FixedVec4& prePos, const FixedVec4& nextPos) const
-{
-	return (nextPos - prePos).y < 0;
-}
-
-inline bool SWRasterizer::IsTopLineFixedPoint(const FixedVec4& prePos, const FixedVec4& nextPos) const
-{
-	return ((nextPos - prePos).y == 0) && ((nextPos - prePos).x > 0);
-}
-
-inline bool SWRasterizer::IsLeftLineFloatingPoint(const Vec4& prePos, const Vec4& nextPos) const
-{
-	return (nextPos - prePos).y < 0;
-}
-
-inline bool SWRasterizer::IsTopLineFloatingPoint(const Vec4& prePos, const Vec4& nextPos) const
-{
-	return ((nextPos - prePos).y == 0) && ((nextPos - prePos).x > 0);
-}
-
-inline Vec4 SWRasterizer::InterpolatePosFixedPoint(
-	FP x,
-	FP y,
-	const FixedVec4& v0Pos,
-	const FixedVec4& v1Pos,
-	const FixedVec4& v2Pos,
-	DF edge01,
-	DF edge12,
-	DF edge20) const
-{
-	DF bary01 = edge01 / mTriSizeMul2;
-	DF bary12 = edge12 / mTriSizeMul2;
-	DF bary20 = edge20 / mTriSizeMul2;
-
-
-	Vec4 pos = Vec4::ZERO;
-	pos.x = x.ToFloat();
-	pos.y = y.ToFloat();	
-	
-	pos.w = static_cast<float>(edge12.ToDouble()) / v0Pos.w.ToFloat()
-		+ static_cast<float>(edge20.ToDouble()) / v1Pos.w.ToFloat()
-		+ static_cast<float>(edge01.ToDouble()) / v2Pos.w.ToFloat();
-	
-	pos.z = 1.0f / pos.w;	
-
-	return pos;	
-}
-
-
-
+}
\ No newline at end of file
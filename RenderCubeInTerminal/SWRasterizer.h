@@ -2,26 +2,28 @@
 
 //#define DEBUG_PROCESS_COORDINATE
  
-// todo : divide swrasterizer's pipeline. remove conversion to fixedvec4 in floating pipeline
-#define NORMAL_RASTERIZATION 0
-#define PARTITION_RASTERIZATION 1
-#define ADVANCED_RASTERIZATION 2
-#define RASTERIZATION_TYPE NORMAL_RASTERIZATION
-
-//#define FIXED_RASTERIZATION
+// bin triangles into screen tiles and rasterize, shade, depth test tiles on worker threads
+#define TILED_RASTERIZATION
+// without tiled rasterization, rasterizer shades and depth tests pixels directly into render, z buffer
+#define FUSED_RASTERIZATION
 
 
 #include "DynamicMemoryPool.hpp"
 #include "Primitive.h"
 #include "List.hpp"
 #include "IRasterizable.h"
-#include "RasterizeFixed.h"
-#include "RasterizeFloating.h"
+#include "RasterizerRegistry.h"
+#include "TriangleSetup.h"
+#include "TileRasterizer.h"
+#include "HierarchicalZ.h"
+#include "VertexShader.h"
 
+class PixelShader;
 class SWRasterizer {
 public:
 	// limit size of viewport for avoiding fixed point overflow
 	// -2^(FP::INT_BITS_LEN-2) <= x, y <= 2^(FP::INT_BITS_LEN-2) - 1	
+	// fixed point engines rasterize in narrow format when viewport is in its guard band (see RasterizerRegistry)
 	// TODO : think size of viewport. in direct3d 11 functional specification, 
 	//		uses 16.8 fixed point and allows range of x, y of viewport is [-2^15, 2^15 - 1].
 	//		but maximun value of edge function is (2^15)^2. it exceeds range of fixed point.
@@ -46,179 +48,177 @@ private:
 		Length
 	};
 
+	// vertex created by clipping edge (inIndex, outIndex) on plane
+	struct ClipEdge {
+		uint32_t inIndex;
+		uint32_t outIndex;
+		PlaneID planeID;
+		uint32_t vertexIndex;
+	};
+
 	static constexpr float HOMOGENEOUS_VERTEX_MIN_Z = 1e-6f;
 	static constexpr uint64_t RESERVED_VERTICES_BYTES = 1024 * 1024 * 1; // 1mb
 	static constexpr uint64_t RESERVED_INDICES_BYTES = 1024 * 1024 * 0.5f; // 0.5mb
+	static constexpr uint64_t RESERVED_MATERIAL_IDS_BYTES = RESERVED_INDICES_BYTES / 3;
 	static constexpr uint64_t RESERVED_PIXELS_BYTES = 128 * 128 * sizeof(Pixel);
+	static constexpr uint64_t RESERVED_SPANS_BYTES = 128 * 16 * sizeof(Span);
+	static constexpr uint64_t RESERVED_OUTCODES_BYTES = RESERVED_VERTICES_BYTES / sizeof(Vertex);
+	static constexpr uint64_t RESERVED_VERTEX_REMAP_BYTES = RESERVED_VERTICES_BYTES / sizeof(Vertex) * sizeof(uint32_t);
+	static constexpr uint32_t EMPTY_VERTEX_INDEX = 0xFFFFFFFF;
+	static constexpr uint64_t RESERVED_POSITION_STREAM_BYTES = RESERVED_VERTICES_BYTES / sizeof(Vertex) * sizeof(float);
+	// power of 2
+	static constexpr uint32_t RESERVED_CLIP_EDGE_NUM = 1024;
+	static constexpr uint32_t EMPTY_CLIP_EDGE = 0xFFFFFFFF;
 
 public:
 	SWRasterizer();
 
 	// assume cw
-	void Initialize();
+	// render target of renderTargetWidth * renderTargetHeight has all viewports. tiles of tiled rasterization cover it
+	void Initialize(uint32_t renderTargetWidth, uint32_t renderTargetHeight, RasterizerEngine engine = RasterizerRegistry::DEFAULT_ENGINE);
 	void Terminate();
 
-	void Execute(const Vertex* vertices, int vertexNum, const uint32_t* indices, int indexNum);
+	// rasterizer can be switched between frames
+	void SetRasterizerEngine(RasterizerEngine engine);
+	inline RasterizerEngine GetRasterizerEngine() const {
+		return mEngine;
+	}
+
+	// vertices, indices are read in place, not copied. only vertices created by clipping are stored in rasterizer.
+	// vertices are in clip space, or are transformed by vertex shader of SetupVertexShader
+	// first varyingNum varyings of vertices are clipped and interpolated perspective correctly to pixels.
+	// materialIDs has indices.num / 3 elements, material of each triangle which reaches its pixels.
+	// so a mesh of several materials is drawn at once. pixels have material 0 when it is null
+	void Execute(const ArrayView<Vertex>& vertices, const ArrayView<uint32_t>& indices, uint32_t varyingNum = 0,
+		const uint32_t* materialIDs = nullptr);
+	// shades and depth tests pixels in tile-local storage instead of adding them to pixel list
+	void ExecuteTiled(const ArrayView<Vertex>& vertices, const ArrayView<uint32_t>& indices, PixelShader* pixelShader,
+		uint32_t varyingNum = 0, const uint32_t* materialIDs = nullptr);
+	// shades and depth tests pixels into render, z buffer which have pitch elements in a row, instead of adding them to pixel list
+	void ExecuteFused(const ArrayView<Vertex>& vertices, const ArrayView<uint32_t>& indices, PixelShader* pixelShader,
+		wchar_t* renderBuffer, float* zBuffer, uint32_t pitch, uint32_t varyingNum = 0, const uint32_t* materialIDs = nullptr);
+	// z buffer of ExecuteFused is cleared outside
+	void InvalidateHierarchicalZ();
+	void ClearTiles(wchar_t clearChar);
+	void ResolveTiles(wchar_t* renderBuffer, float* zBuffer, uint32_t pitch) const;
 	inline uint64_t GetPixelLength() const {
 		return mPixels->GetSize();
 	}
 	inline const Pixel& GetPixel(uint32_t index) const {
 		return mPixels->At<Pixel>(index);
 	}
+	// pixels which rasterizer added as spans are not in pixel list
+	inline uint64_t GetSpanLength() const {
+		return mSpans->GetSize();
+	}
+	inline const Span& GetSpan(uint32_t index) const {
+		return mSpans->At<Span>(index);
+	}
 
 	void SetupViewport(const Viewport& viewport);
+	// vertex shader of next draws. null means vertices of draws are already in clip space
+	void SetupVertexShader(VertexShader* vertexShader, const VertexUniforms& uniforms);
 
 private:
+	// recreate rasterizers after engine or fixed point precision is changed
+	void ResetRasterizers();
+	// guard band. range of x, y in viewport space which fixed point allows (see Viewport).
+	//		triangles are clipped on x, y planes only when they go out of guard band,
+	//		inside it, rasterizer limits pixels to scissor of viewport.
+	//		it depends on engine and fixed point precision
+	void SetupGuardBand();
+
+	// cull, clip, divide, transform viewport, and setup triangles for fixed point engines in mTriangleSetup
+	//		pViewportVertices : float vertices in viewport space
+	//		pRasterVertices : vertices for rasterizer. fixed or float
+	//		pMaterialIDs : material of each remain triangle. null when materialIDs is null
+	void ProcessGeometry(const List** pViewportVertices, const List** pRasterVertices, const List** pCulledIndices, const List** pMaterialIDs,
+		const ArrayView<Vertex>& vertices, const ArrayView<uint32_t>& indices, uint32_t varyingNum, const uint32_t* materialIDs);
+	inline ScissorRect GetViewportRect() const;
+	inline ScissorRect GetRenderTargetRect() const;
+	// pixels are added only in it. viewport cut by render target
+	inline ScissorRect GetScissorRect() const;
+
+	// vertex of draw. input vertices, then vertices created by clipping
+	inline const Vertex& GetVertex(uint32_t index) const {
+		return index < mInputVertices.num ? mInputVertices[index] : mClipVertices->At<Vertex>(index - mInputVertices.num);
+	}
+	inline uint32_t GetVertexNum() const {
+		return mInputVertices.num + static_cast<uint32_t>(mClipVertices->GetSize());
+	}
+
 	// clip
-	void Clip(List** pClippedVertices, List** pClippedIndices, const List* vertices, const List* indices);
-	void ClipTriangle(bool* pIsClipped, uint8_t* pClippedIndexNum, uint8_t* pClippedVertexNum, Vertex(&clippedVertices)[9], uint32_t(&clippedIndices)[21], const Triangle& triangle);
+	//		not clipped triangles keep their indices. vertices created by clipping are added to mClipVertices
+	//		triangles created by clipping a triangle have its material. material lists are null together
+	void Clip(List** pClippedIndices, List** pClippedMaterialIDs, const List* indices, const List* materialIDs);
+	// outcode of input vertex has bit (1 << PlaneID) when vertex is out of plane
+	void CalculateOutcodes(List** pOutcodes);
+	// clip only on planes in planeMask
+	void ClipTriangle(List** pClippedIndices, const uint32_t(&triangleIndices)[3], uint8_t planeMask);
+	// index of vertex on edge, which is created only once per edge and plane
+	uint32_t GetInterVertexIndex(PlaneID planeID, uint32_t inIndex, uint32_t outIndex);
+	void ResetClipEdges();
+	void ResizeClipEdges(uint32_t capacity);
+	inline uint32_t HashClipEdge(uint32_t inIndex, uint32_t outIndex, PlaneID planeID) const {
+		return (inIndex * 73856093u) ^ (outIndex * 19349663u) ^ (static_cast<uint32_t>(planeID) * 83492791u);
+	}
 	inline bool IsInPlane(PlaneID planeID, const Vertex& clipVertex);
 	inline float GetSignedDstWithPlane(PlaneID planeID, const Vertex& clipVertex);
 	inline Vertex CalculateInterVertex(PlaneID planeID, const Vertex& inV, const Vertex& outV);
 
-	// perspective division
-	void DividePerspective(List** pVertices);
-
-	// back face culling
-	void CullBackFace(List** pCulledIndices, const List* indices, const List* vertices);
-
-	// viewport
-	void TransformViewport(List** pVertices);
+	// back face culling on input vertices. pCulledMaterialIDs is null when materialIDs is null
+	void CullBackFace(List** pCulledIndices, List** pCulledMaterialIDs, const ArrayView<uint32_t>& indices, const uint32_t* materialIDs);
 
-	// Convert to FP
-	void ConvertFixedPoint(List** pOutVertices, const List* vertices);
+	// copy positions and varyings of vertices referenced by indices to streams in order of first reference, and remap indices
+	void CompactVertices(List** pIndices);
 
-	// Rasterization
-	void RasterizeFixedPoint(const List* fixedVertices, const List* indices);
-	void RasterizeFloatingPoint(const List* floatingVertices, const List* indices);
-
-	inline DF EdgeFunctionFixedPoint(const FixedVec4& pixelPos, const FixedVec4& v0Pos, const FixedVec4& v1Pos) const
-	{
-		FixedVec4 pMinusV0 = pixelPos - v0Pos;
-		FixedVec4 v1MinusV0 = v1Pos - v0Pos;
-
-		DF v0PX = pMinusV0.x.ToDoubleFixedPoint();
-		DF v0V1Y = v1MinusV0.y.ToDoubleFixedPoint();
-		DF v0PY = pMinusV0.y.ToDoubleFixedPoint();
-		DF v0V1X = v1MinusV0.x.ToDoubleFixedPoint();
-
-		return v0PX * v0V1Y - v0PY * v0V1X;
-	}
-
-	inline float EdgeFunctionFloatingPoint(const Vec4& pixelPos, const Vec4& v0Pos, const Vec4 v1Pos) const 
-	{
-		Vec4 pMinusV0 = pixelPos - v0Pos;
-		Vec4 v1MinusV0 = v1Pos - v0Pos;
-
-		return pMinusV0.x * v1MinusV0.y - pMinusV0.y * v1MinusV0.x;
-	}
-
-	void RasterizePartFixedPoint(
-		const FixedVec4& v0Pos,
-		const FixedVec4& v1Pos,
-		const FixedVec4& v2Pos,
-		FP leftX,
-		FP topY,
-		uint8_t pixelLengthLog2,		
-		DF edge01,
-		DF edge12,
-		DF edge20);
-	void RasterizePartFloatingPoint(
-		const Vec4& v0Pos,
-		const Vec4& v1Pos,
-		const Vec4& v2Pos,
-		float leftX,
-		float topY,
-		uint8_t pixelLengthLog2,
-		float edge01,
-		float edge12,
-		float edge20);
-
-	inline void AddPixelIsInTriangleFixedPoint(
-		const FixedVec4& v0Pos,
-		const FixedVec4& v1Pos,
-		const FixedVec4& v2Pos,
-		FP x,
-		FP y,
-		DF edge01,
-		DF edge12,
-		DF edge20);
-	inline void AddPixelIsInTriangleFloatingPoint(
-		const Vec4& v0Pos,
-		const Vec4& v1Pos,
-		const Vec4& v2Pos,
-		float x,
-		float y,
-		float edge01,
-		float edge12,
-		float edge23
-	);
-
-	inline bool IsSelectPixelFixedPoint(
-		const FixedVec4& v0Pos,
-		const FixedVec4& v1Pos,
-		const FixedVec4& v2Pos,
-		FP x,
-		FP y,
-		DF edge01,
-		DF edge12,
-		DF edge20
-	);
-	inline bool IsSelectPixelFloatingPoint(
-		const Vec4& v0Pos,
-		const Vec4& v1Pos,
-		const Vec4& v2Pos,
-		float x,
-		float y,
-		float edge01,
-		float edge12,
-		float edge20
-	);
-
-	inline bool IsLeftLineFixedPoint(const FixedVec4& prePos, const FixedVec4& nextPos) const;
-	inline bool IsTopLineFixedPoint(const FixedVec4& prePos, const FixedVec4& nextPos) const;
-	inline bool IsLeftLineFloatingPoint(const Vec4& prePos, const Vec4& nextPos) const;
-	inline bool IsTopLineFloatingPoint(const Vec4& prePos, const Vec4& nextPos) const;
-
-
-	inline Vec4 InterpolatePosFixedPoint(
-		FP x,
-		FP y,
-		const FixedVec4& v0Pos,
-		const FixedVec4& v1Pos,
-		const FixedVec4& v2Pos, 
-		DF edge01,
-		DF edge12, 
-		DF edge20) const;
+	// perspective division, viewport transform of position streams.
+	// also converts to fixed point when pFixedVertices is not null. varyings are copied from varying stream
+	void TransformVertices(List** pViewportVertices, List** pFixedVertices);
 
 private:	
-	int mVertexNum = 0;
-	int mIndexNum = 0;
+	VertexShader* mVertexShader = nullptr;
+	VertexUniforms mVertexUniforms;
+	// output of vertex shader, reused every draw
+	List* mShadedVertices = nullptr;
+	// vertices of draw in caller's memory, or in mShadedVertices
+	ArrayView<Vertex> mInputVertices;
+	// vertices created by clipping in draw
+	List* mClipVertices = nullptr;
+	uint32_t mVaryingNum = 0;
 	Viewport mViewport = {0};
+	uint32_t mRenderTargetWidth = 0;
+	uint32_t mRenderTargetHeight = 0;
+	// guard band in ndc. clip space x, y planes are x = mGuardBandMinX * w ...
+	float mGuardBandMinX = -1.0f;
+	float mGuardBandMaxX = 1.0f;
+	float mGuardBandMinY = -1.0f;
+	float mGuardBandMaxY = 1.0f;
 
 	List* mPixels = nullptr;
+	List* mSpans = nullptr;
+	List* mOutcodes = nullptr;
+	List* mVertexRemap = nullptr;
+	// SoA x, y, z, w of compacted vertices
+	List* mPositionStreams[4] = { nullptr, };
+	// mVaryingNum varyings of each compacted vertex
+	List* mVaryingStream = nullptr;
+
+	// open addressing table of clipped edges
+	ClipEdge* mClipEdges = nullptr;
+	uint32_t mClipEdgeCapacity = 0;
+	uint32_t mClipEdgeNum = 0;
 	List* mVerticesPool[2] = {nullptr, };
 	List* mIndicesPool[2] = { nullptr, };
+	List* mMaterialIDsPool[2] = { nullptr, };
 	
-	IRasterizable* mRasterize;
-
-	// dxEdgeFunctionValue, 2 * dxEdgeFunctionValue, 4 * dxEdgeFunctionValue, 8 * dxEdgeFunctionValue
-	DF mDxEdge01s[4];
-	DF mDxEdge12s[4];
-	DF mDxEdge20s[4];
-	// dyEdgeFunctionValue, 2 * dyEdgeFunctionValue, 4 * dyEdgeFunctionValue, 8 * dyEdgeFunctionValue
-	DF mDyEdge01s[4];
-	DF mDyEdge12s[4];
-	DF mDyEdge20s[4];
-	
-	DF mTriSizeMul2;
-
-	// bbox covers triangle
-	FP mMinX = FP::ZERO;
-	FP mMaxX = FP::ZERO;
-	FP mMinY = FP::ZERO;
-	FP mMaxY = FP::ZERO;
-
-
-
+	RasterizerEngine mEngine = RasterizerRegistry::DEFAULT_ENGINE;
+	FixedPointPrecision mFixedPointPrecision = FixedPointPrecision::Wide;
+	// rasterizer of engine. the other kind is null
+	IRasterizable* mFloatingRasterize = nullptr;
+	ISetupRasterizable* mFixedRasterize = nullptr;
+	// triangles of draw set up for fixed point engines, which rasterizers of all tiles read. null for floating point engines
+	TriangleSetupBase* mTriangleSetup = nullptr;
+	TileRasterizer* mTileRasterizer = nullptr;
+	HierarchicalZ* mHierarchicalZ = nullptr;
 };
\ No newline at end of file
@@ -5,13 +5,33 @@ void SimplePixelShader::SetCharacter(wchar_t c)
     mCharacter = c;
 }
 
+void SimplePixelShader::SetMaterialCharacters(const wchar_t* characters, uint32_t materialNum)
+{
+    mMaterialCharacters = characters;
+    mMaterialNum = materialNum;
+}
+
 PixelShaderManager::OutPixel SimplePixelShader::ExecuteOnePixel(const Pixel& pixel)
 {
     PixelShaderManager::OutPixel out;
     out.x = pixel.pos.x;
     out.y = pixel.pos.y;
     out.depth = pixel.pos.z;
-    out.c = mCharacter;
+    out.c = GetCharacter(pixel.materialID);
 
     return out;
 }
+
+void SimplePixelShader::ExecuteSpan(const Span& span, PixelShaderManager::OutPixel* outPixels)
+{
+    // character is same for all pixels, only depth varies along span
+    float y = static_cast<float>(span.y) + 0.5f;
+    wchar_t c = GetCharacter(span.materialID);
+    for (uint32_t i = 0; i < span.length; i++) {
+        PixelShaderManager::OutPixel& out = outPixels[i];
+        out.x = static_cast<float>(span.leftX + static_cast<int32_t>(i)) + 0.5f;
+        out.y = y;
+        out.depth = 1.0f / (span.invW + span.invWDx * static_cast<float>(i));
+        out.c = c;
+    }
+}
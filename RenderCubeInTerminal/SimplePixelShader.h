@@ -4,8 +4,19 @@
 class SimplePixelShader : public PixelShader {	
 public:
 	void SetCharacter(wchar_t c);
+	// pixel of material i gets characters[i], materials out of table get character of SetCharacter.
+	// characters are not copied
+	void SetMaterialCharacters(const wchar_t* characters, uint32_t materialNum);
 	virtual PixelShaderManager::OutPixel ExecuteOnePixel(const Pixel& pixel) override;
+	virtual void ExecuteSpan(const Span& span, PixelShaderManager::OutPixel* outPixels) override;
+
+private:
+	inline wchar_t GetCharacter(uint32_t materialID) const {
+		return materialID < mMaterialNum ? mMaterialCharacters[materialID] : mCharacter;
+	}
 
 private:
 	wchar_t mCharacter = L' ';
+	const wchar_t* mMaterialCharacters = nullptr;
+	uint32_t mMaterialNum = 0;
 };
\ No newline at end of file
@@ -0,0 +1,15 @@
+#include "SimpleVertexShader.h"
+
+void SimpleVertexShader::Execute(const VertexUniforms& uniforms, const ArrayView<Vertex>& vertices, uint32_t varyingNum, Vertex* outVertices)
+{
+    if (vertices.num == 0) {
+        return;
+    }
+
+    // positions of all vertices are transformed at once, skipping varyings by stride
+    Mat4x4::Transform(uniforms.modelViewProjection, &vertices[0].pos, vertices.stride, &outVertices[0].pos, sizeof(Vertex), vertices.num);
+
+    for (uint32_t i = 0; i < vertices.num; i++) {
+        memcpy(outVertices[i].varyings, vertices[i].varyings, varyingNum * sizeof(float));
+    }
+}
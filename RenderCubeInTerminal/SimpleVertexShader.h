@@ -0,0 +1,8 @@
+#pragma once
+#include "VertexShader.h"
+
+// position is transformed by model view projection, varyings are passed through
+class SimpleVertexShader : public VertexShader {
+public:
+	virtual void Execute(const VertexUniforms& uniforms, const ArrayView<Vertex>& vertices, uint32_t varyingNum, Vertex* outVertices) override;
+};
@@ -0,0 +1,348 @@
+#include "TileRasterizer.h"
+#include "TriangleSetup.h"
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+TileRasterizer::TileRasterizer()
+{
+}
+
+TileRasterizer::~TileRasterizer()
+{
+	Terminate();
+}
+
+void TileRasterizer::Initialize(const ScissorRect& renderTargetRect, uint32_t workerThreadNum, RasterizerEngine engine,
+	FixedPointPrecision precision)
+{
+	CreateTiles(renderTargetRect);
+	mScissorRect = renderTargetRect;
+
+	mWorkerThreadNum = workerThreadNum;
+	CreateWorkerRasterizers(engine, precision);
+
+	mIsTerminate = false;
+	mWorkerThreads = new std::thread[mWorkerThreadNum];
+	for (uint32_t i = 0; i < mWorkerThreadNum; i++) {
+		mWorkerThreads[i] = std::thread(&TileRasterizer::WorkerLoop, this, i + 1);
+	}
+}
+
+void TileRasterizer::Terminate()
+{
+	// stop workers
+	if (mWorkerThreads != nullptr) {
+		{
+			std::lock_guard<std::mutex> lock(mJobMutex);
+			mIsTerminate = true;
+		}
+		mJobCondition.notify_all();
+
+		for (uint32_t i = 0; i < mWorkerThreadNum; i++) {
+			mWorkerThreads[i].join();
+		}
+
+		delete[] mWorkerThreads;
+		mWorkerThreads = nullptr;
+	}
+
+	DestroyWorkerRasterizers();
+
+	mWorkerThreadNum = 0;
+
+	DestroyTiles();
+}
+
+void TileRasterizer::SetRasterizerEngine(RasterizerEngine engine, FixedPointPrecision precision)
+{
+	// workers sleep between jobs, so their rasterizers can be replaced here
+	DestroyWorkerRasterizers();
+	CreateWorkerRasterizers(engine, precision);
+}
+
+void TileRasterizer::SetupViewport(const ScissorRect& viewportRect)
+{
+	// pixels of draws before it stay in tiles, so only scissor changes
+	mScissorRect.leftX = std::max(viewportRect.leftX, mRenderTargetRect.leftX);
+	mScissorRect.topY = std::max(viewportRect.topY, mRenderTargetRect.topY);
+	mScissorRect.rightX = std::min(viewportRect.rightX, mRenderTargetRect.rightX);
+	mScissorRect.bottomY = std::min(viewportRect.bottomY, mRenderTargetRect.bottomY);
+}
+
+void TileRasterizer::Clear(wchar_t clearChar)
+{
+	for (uint32_t i = 0; i < mTileNum; i++) {
+		for (int32_t j = 0; j < TILE_SIZE * TILE_SIZE; j++) {
+			mTiles[i].depths[j] = (std::numeric_limits<float>::max)();
+			mTiles[i].chars[j] = clearChar;
+		}
+		mTiles[i].hierarchicalZ->Invalidate();
+	}
+}
+
+void TileRasterizer::Bin(const List* viewportVertices, const List* indices, const List* materialIDs)
+{
+	for (uint32_t i = 0; i < mTileNum; i++) {
+		mTiles[i].triangleIndices->Reset(sizeof(uint32_t));
+		mTiles[i].triangleMaterialIDs->Reset(sizeof(uint32_t));
+	}
+	mHasMaterialIDs = materialIDs != nullptr;
+	mTriangleSetup = nullptr;
+
+	for (uint32_t indexIdx = 0; indexIdx < indices->GetSize(); indexIdx += 3) {
+		uint32_t i0 = indices->At<uint32_t>(indexIdx);
+		uint32_t i1 = indices->At<uint32_t>(indexIdx + 1);
+		uint32_t i2 = indices->At<uint32_t>(indexIdx + 2);
+		const Vec4& p0 = viewportVertices->At<Vertex>(i0).pos;
+		const Vec4& p1 = viewportVertices->At<Vertex>(i1).pos;
+		const Vec4& p2 = viewportVertices->At<Vertex>(i2).pos;
+
+		// tiles overlapped by bbox of triangle
+		int32_t minTileX, minTileY, maxTileX, maxTileY;
+		if (GetTileRange(static_cast<int32_t>(floorf(std::min(p0.x, std::min(p1.x, p2.x)))),
+			static_cast<int32_t>(floorf(std::min(p0.y, std::min(p1.y, p2.y)))),
+			static_cast<int32_t>(floorf(std::max(p0.x, std::max(p1.x, p2.x)))),
+			static_cast<int32_t>(floorf(std::max(p0.y, std::max(p1.y, p2.y)))),
+			&minTileX, &minTileY, &maxTileX, &maxTileY) == false) {
+			continue;
+		}
+
+		for (int32_t tileY = minTileY; tileY <= maxTileY; tileY++) {
+			for (int32_t tileX = minTileX; tileX <= maxTileX; tileX++) {
+				List* tileIndices = mTiles[tileY * mTileXNum + tileX].triangleIndices;
+				tileIndices->Add<uint32_t>(i0);
+				tileIndices->Add<uint32_t>(i1);
+				tileIndices->Add<uint32_t>(i2);
+				if (materialIDs != nullptr) {
+					mTiles[tileY * mTileXNum + tileX].triangleMaterialIDs->Add<uint32_t>(materialIDs->At<uint32_t>(indexIdx / 3));
+				}
+			}
+		}
+	}
+}
+
+void TileRasterizer::Bin(const TriangleSetupBase* setup)
+{
+	for (uint32_t i = 0; i < mTileNum; i++) {
+		mTiles[i].triangleIndices->Reset(sizeof(uint32_t));
+	}
+	mHasMaterialIDs = false;
+	mTriangleSetup = setup;
+
+	// bbox of setup has pixels which are covered possibly
+	uint32_t triangleNum = setup->GetTriangleNum();
+	for (uint32_t triangle = 0; triangle < triangleNum; triangle++) {
+		int32_t minTileX, minTileY, maxTileX, maxTileY;
+		if (GetTileRange(setup->GetMinX(triangle), setup->GetMinY(triangle), setup->GetMaxX(triangle), setup->GetMaxY(triangle),
+			&minTileX, &minTileY, &maxTileX, &maxTileY) == false) {
+			continue;
+		}
+
+		for (int32_t tileY = minTileY; tileY <= maxTileY; tileY++) {
+			for (int32_t tileX = minTileX; tileX <= maxTileX; tileX++) {
+				mTiles[tileY * mTileXNum + tileX].triangleIndices->Add<uint32_t>(triangle);
+			}
+		}
+	}
+}
+
+void TileRasterizer::Execute(const List* rasterVertices, uint32_t varyingNum, PixelShader* pixelShader)
+{
+	assert(pixelShader != nullptr);
+
+	mRasterVertices = rasterVertices;
+	mVaryingNum = varyingNum;
+	mPixelShader = pixelShader;
+	mNextTileIndex = 0;
+
+	// wake workers
+	{
+		std::lock_guard<std::mutex> lock(mJobMutex);
+		mRemainWorkerNum = mWorkerThreadNum;
+		mJobId++;
+	}
+	mJobCondition.notify_all();
+
+	// calling thread works too
+	ProcessTiles(0);
+
+	// wait workers
+	std::unique_lock<std::mutex> lock(mJobMutex);
+	mDoneCondition.wait(lock, [this] { return mRemainWorkerNum == 0; });
+}
+
+void TileRasterizer::Resolve(wchar_t* renderBuffer, float* zBuffer, uint32_t pitch) const
+{
+	for (uint32_t i = 0; i < mTileNum; i++) {
+		const Tile& tile = mTiles[i];
+		int32_t width = tile.rect.rightX - tile.rect.leftX;
+		for (int32_t y = tile.rect.topY; y < tile.rect.bottomY; y++) {
+			int32_t tileRowStart = (y - tile.rect.topY) * TILE_SIZE;
+			uint32_t bufferRowStart = y * pitch + tile.rect.leftX;
+			memcpy(renderBuffer + bufferRowStart, tile.chars + tileRowStart, width * sizeof(wchar_t));
+			memcpy(zBuffer + bufferRowStart, tile.depths + tileRowStart, width * sizeof(float));
+		}
+	}
+}
+
+void TileRasterizer::CreateTiles(const ScissorRect& renderTargetRect)
+{
+	mRenderTargetRect = renderTargetRect;
+
+	int32_t width = renderTargetRect.rightX - renderTargetRect.leftX;
+	int32_t height = renderTargetRect.bottomY - renderTargetRect.topY;
+	mTileXNum = (width + TILE_SIZE - 1) / TILE_SIZE;
+	mTileYNum = (height + TILE_SIZE - 1) / TILE_SIZE;
+	mTileNum = mTileXNum * mTileYNum;
+
+	mTiles = new Tile[mTileNum];
+	for (uint32_t tileY = 0; tileY < mTileYNum; tileY++) {
+		for (uint32_t tileX = 0; tileX < mTileXNum; tileX++) {
+			Tile& tile = mTiles[tileY * mTileXNum + tileX];
+
+			// edge tiles are cut by render target
+			tile.rect.leftX = renderTargetRect.leftX + tileX * TILE_SIZE;
+			tile.rect.topY = renderTargetRect.topY + tileY * TILE_SIZE;
+			tile.rect.rightX = std::min(tile.rect.leftX + TILE_SIZE, renderTargetRect.rightX);
+			tile.rect.bottomY = std::min(tile.rect.topY + TILE_SIZE, renderTargetRect.bottomY);
+
+			tile.triangleIndices = new List(1, RESERVED_TILE_INDICES_BYTES);
+			tile.triangleIndices->Reset(sizeof(uint32_t));
+			tile.triangleMaterialIDs = new List(1, RESERVED_TILE_MATERIAL_IDS_BYTES);
+			tile.triangleMaterialIDs->Reset(sizeof(uint32_t));
+			tile.depths = new float[TILE_SIZE * TILE_SIZE];
+			tile.chars = new wchar_t[TILE_SIZE * TILE_SIZE];
+			tile.hierarchicalZ = new HierarchicalZ();
+			tile.hierarchicalZ->Setup(tile.rect, tile.depths, TILE_SIZE);
+		}
+	}
+
+	// tiles are resolved as they are, even if they are not cleared before
+	Clear(L' ');
+}
+
+void TileRasterizer::DestroyTiles()
+{
+	if (mTiles == nullptr) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < mTileNum; i++) {
+		delete mTiles[i].triangleIndices;
+		delete mTiles[i].triangleMaterialIDs;
+		delete[] mTiles[i].depths;
+		delete[] mTiles[i].chars;
+		delete mTiles[i].hierarchicalZ;
+	}
+	delete[] mTiles;
+	mTiles = nullptr;
+
+	mTileXNum = 0;
+	mTileYNum = 0;
+	mTileNum = 0;
+}
+
+bool TileRasterizer::GetTileRange(int32_t minX, int32_t minY, int32_t maxX, int32_t maxY,
+	int32_t* pMinTileX, int32_t* pMinTileY, int32_t* pMaxTileX, int32_t* pMaxTileY) const
+{
+	minX = std::max(minX, mScissorRect.leftX);
+	minY = std::max(minY, mScissorRect.topY);
+	maxX = std::min(maxX, mScissorRect.rightX - 1);
+	maxY = std::min(maxY, mScissorRect.bottomY - 1);
+	if (minX > maxX || minY > maxY) {
+		return false;
+	}
+
+	*pMinTileX = (minX - mRenderTargetRect.leftX) / TILE_SIZE;
+	*pMinTileY = (minY - mRenderTargetRect.topY) / TILE_SIZE;
+	*pMaxTileX = (maxX - mRenderTargetRect.leftX) / TILE_SIZE;
+	*pMaxTileY = (maxY - mRenderTargetRect.topY) / TILE_SIZE;
+
+	return true;
+}
+
+void TileRasterizer::CreateWorkerRasterizers(RasterizerEngine engine, FixedPointPrecision precision)
+{
+	bool isFixedPoint = RasterizerRegistry::GetEntry(engine).isFixedPoint;
+	mWorkerFloatingRasterizers = new IRasterizable*[GetWorkerNum()];
+	mWorkerFixedRasterizers = new ISetupRasterizable*[GetWorkerNum()];
+	for (uint32_t i = 0; i < GetWorkerNum(); i++) {
+		mWorkerFloatingRasterizers[i] = isFixedPoint ? nullptr : RasterizerRegistry::CreateFloating(engine);
+		mWorkerFixedRasterizers[i] = isFixedPoint ? RasterizerRegistry::CreateFixed(engine, precision) : nullptr;
+	}
+}
+
+void TileRasterizer::DestroyWorkerRasterizers()
+{
+	if (mWorkerFloatingRasterizers == nullptr) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < GetWorkerNum(); i++) {
+		delete mWorkerFloatingRasterizers[i];
+		delete mWorkerFixedRasterizers[i];
+	}
+	delete[] mWorkerFloatingRasterizers;
+	mWorkerFloatingRasterizers = nullptr;
+	delete[] mWorkerFixedRasterizers;
+	mWorkerFixedRasterizers = nullptr;
+}
+
+void TileRasterizer::WorkerLoop(uint32_t workerIndex)
+{
+	uint64_t doneJobId = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mJobMutex);
+			mJobCondition.wait(lock, [this, doneJobId] { return mIsTerminate || mJobId != doneJobId; });
+			if (mIsTerminate) {
+				return;
+			}
+			doneJobId = mJobId;
+		}
+
+		ProcessTiles(workerIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(mJobMutex);
+			mRemainWorkerNum--;
+			if (mRemainWorkerNum == 0) {
+				mDoneCondition.notify_one();
+			}
+		}
+	}
+}
+
+void TileRasterizer::ProcessTiles(uint32_t workerIndex)
+{
+	// tiles are taken one by one, so busy tiles don't stall other workers
+	for (uint32_t tileIndex = mNextTileIndex.fetch_add(1);
+		tileIndex < mTileNum;
+		tileIndex = mNextTileIndex.fetch_add(1)) {
+		ProcessTile(workerIndex, mTiles[tileIndex]);
+	}
+}
+
+void TileRasterizer::ProcessTile(uint32_t workerIndex, Tile& tile)
+{
+	if (tile.triangleIndices->GetSize() == 0) {
+		return;
+	}
+
+	// rasterize, pixel shader & depth test into tile storage, only in viewport
+	ScissorRect scissor;
+	scissor.leftX = std::max(tile.rect.leftX, mScissorRect.leftX);
+	scissor.topY = std::max(tile.rect.topY, mScissorRect.topY);
+	scissor.rightX = std::min(tile.rect.rightX, mScissorRect.rightX);
+	scissor.bottomY = std::min(tile.rect.bottomY, mScissorRect.bottomY);
+
+	PixelOutput output(mPixelShader, tile.chars, tile.depths, TILE_SIZE, tile.rect.leftX, tile.rect.topY, tile.hierarchicalZ);
+	if (mTriangleSetup != nullptr) {
+		mWorkerFixedRasterizers[workerIndex]->Rasterize(&output, mRasterVertices, *mTriangleSetup, tile.triangleIndices, scissor, mVaryingNum);
+		return;
+	}
+
+	mWorkerFloatingRasterizers[workerIndex]->Rasterize(&output, mRasterVertices, tile.triangleIndices, mHasMaterialIDs ? tile.triangleMaterialIDs : nullptr,
+		scissor, mVaryingNum);
+}
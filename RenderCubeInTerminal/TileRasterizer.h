@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Primitive.h"
+#include "List.hpp"
+#include "IRasterizable.h"
+#include "RasterizerRegistry.h"
+#include "HierarchicalZ.h"
+
+class PixelShader;
+
+/// <summary>
+/// Bins triangles into fixed-size screen tiles and rasterizes, shades, depth tests tiles in parallel.
+/// Each tile owns its depth, character storage, so workers never share pixels of render target.
+/// Tiles cover whole render target, so draws of different viewports in a scene are kept in them until Resolve.
+/// Execute must be called on one thread.
+/// </summary>
+class TileRasterizer {
+public:
+	static constexpr int32_t TILE_SIZE = 16;
+
+private:
+	struct Tile {
+		ScissorRect rect;
+		// indices of vertices of triangles, or indices of triangles in setup when tiles are binned with setup
+		List* triangleIndices;
+		List* triangleMaterialIDs;
+		float* depths;
+		wchar_t* chars;
+		HierarchicalZ* hierarchicalZ;
+	};
+
+	static constexpr uint64_t RESERVED_TILE_INDICES_BYTES = 256 * 3 * sizeof(uint32_t);
+	static constexpr uint64_t RESERVED_TILE_MATERIAL_IDS_BYTES = 256 * sizeof(uint32_t);
+
+public:
+	TileRasterizer();
+	~TileRasterizer();
+
+	// rasterizer of engine is created per worker
+	void Initialize(const ScissorRect& renderTargetRect, uint32_t workerThreadNum, RasterizerEngine engine,
+		FixedPointPrecision precision = FixedPointPrecision::Wide);
+	void Terminate();
+
+	// must not be called during Execute
+	void SetRasterizerEngine(RasterizerEngine engine, FixedPointPrecision precision = FixedPointPrecision::Wide);
+
+	// next draws are binned and rasterized only in viewport. tiles are kept
+	void SetupViewport(const ScissorRect& viewportRect);
+	void Clear(wchar_t clearChar);
+
+	// viewportVertices : float vertices in viewport space. used for binning
+	// rasterVertices : vertices which rasterizer of workers consume
+	// varyingNum : number of varyings interpolated to pixels
+	// materialIDs : material of each triangle. can be null
+	void Bin(const List* viewportVertices, const List* indices, const List* materialIDs);
+	// bin triangles which are set up for fixed point engines, by bbox of setup.
+	//		setup must be kept until Execute
+	void Bin(const TriangleSetupBase* setup);
+	void Execute(const List* rasterVertices, uint32_t varyingNum, PixelShader* pixelShader);
+
+	// copy tiles to render, z buffer which have pitch elements in a row
+	void Resolve(wchar_t* renderBuffer, float* zBuffer, uint32_t pitch) const;
+
+	inline uint32_t GetWorkerNum() const {
+		return mWorkerThreadNum + 1;
+	}
+
+private:
+	void CreateTiles(const ScissorRect& renderTargetRect);
+	void DestroyTiles();
+	// tiles overlapped by pixels [minX, maxX] x [minY, maxY] in scissor. false if none
+	bool GetTileRange(int32_t minX, int32_t minY, int32_t maxX, int32_t maxY,
+		int32_t* pMinTileX, int32_t* pMinTileY, int32_t* pMaxTileX, int32_t* pMaxTileY) const;
+
+	void CreateWorkerRasterizers(RasterizerEngine engine, FixedPointPrecision precision);
+	void DestroyWorkerRasterizers();
+
+	void WorkerLoop(uint32_t workerIndex);
+	void ProcessTiles(uint32_t workerIndex);
+	void ProcessTile(uint32_t workerIndex, Tile& tile);
+
+private:
+	// tiles
+	ScissorRect mRenderTargetRect = {};
+	// viewport cut by render target
+	ScissorRect mScissorRect = {};
+	Tile* mTiles = nullptr;
+	uint32_t mTileXNum = 0;
+	uint32_t mTileYNum = 0;
+	uint32_t mTileNum = 0;
+
+	// workers. index 0 is the thread calling Execute
+	uint32_t mWorkerThreadNum = 0;
+	std::thread* mWorkerThreads = nullptr;
+	// rasterizer of engine. the other kind is null
+	IRasterizable** mWorkerFloatingRasterizers = nullptr;
+	ISetupRasterizable** mWorkerFixedRasterizers = nullptr;
+
+	// job
+	const List* mRasterVertices = nullptr;
+	// null when tiles are binned with indices
+	const TriangleSetupBase* mTriangleSetup = nullptr;
+	bool mHasMaterialIDs = false;
+	uint32_t mVaryingNum = 0;
+	PixelShader* mPixelShader = nullptr;
+	std::atomic<uint32_t> mNextTileIndex{ 0 };
+
+	std::mutex mJobMutex;
+	std::condition_variable mJobCondition;
+	std::condition_variable mDoneCondition;
+	uint64_t mJobId = 0;
+	uint32_t mRemainWorkerNum = 0;
+	bool mIsTerminate = false;
+};
\ No newline at end of file
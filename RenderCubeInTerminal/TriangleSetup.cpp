@@ -0,0 +1,171 @@
+#include "TriangleSetup.h"
+
+TriangleSetupBase::TriangleSetupBase()
+{
+	mMinXs = new List(sizeof(int32_t), RESERVED_TRIANGLE_NUM);
+	mMinYs = new List(sizeof(int32_t), RESERVED_TRIANGLE_NUM);
+	mMaxXs = new List(sizeof(int32_t), RESERVED_TRIANGLE_NUM);
+	mMaxYs = new List(sizeof(int32_t), RESERVED_TRIANGLE_NUM);
+	mInvTriSizeMul2s = new List(sizeof(double), RESERVED_TRIANGLE_NUM);
+	mMaterialIDs = new List(sizeof(uint32_t), RESERVED_TRIANGLE_NUM);
+
+	for (uint8_t v = 0; v < 3; v++) {
+		mVertexIndices[v] = new List(sizeof(uint32_t), RESERVED_TRIANGLE_NUM);
+		mVertexWs[v] = new List(sizeof(float), RESERVED_TRIANGLE_NUM);
+	}
+}
+
+TriangleSetupBase::~TriangleSetupBase()
+{
+	delete mMinXs;
+	delete mMinYs;
+	delete mMaxXs;
+	delete mMaxYs;
+	delete mInvTriSizeMul2s;
+	delete mMaterialIDs;
+
+	for (uint8_t v = 0; v < 3; v++) {
+		delete mVertexIndices[v];
+		delete mVertexWs[v];
+	}
+}
+
+void TriangleSetupBase::Reset()
+{
+	mMinXs->Reset(sizeof(int32_t));
+	mMinYs->Reset(sizeof(int32_t));
+	mMaxXs->Reset(sizeof(int32_t));
+	mMaxYs->Reset(sizeof(int32_t));
+	mInvTriSizeMul2s->Reset(sizeof(double));
+	mMaterialIDs->Reset(sizeof(uint32_t));
+	for (uint8_t v = 0; v < 3; v++) {
+		mVertexIndices[v]->Reset(sizeof(uint32_t));
+		mVertexWs[v]->Reset(sizeof(float));
+	}
+}
+
+template<typename FORMAT>
+TriangleSetup<FORMAT>::TriangleSetup()
+{
+	for (uint8_t e = 0; e < EDGE_NUM; e++) {
+		mEdgeXs[e] = new List(sizeof(DF), RESERVED_TRIANGLE_NUM);
+		mEdgeYs[e] = new List(sizeof(DF), RESERVED_TRIANGLE_NUM);
+		mEdgeConstants[e] = new List(sizeof(DF), RESERVED_TRIANGLE_NUM);
+	}
+}
+
+template<typename FORMAT>
+TriangleSetup<FORMAT>::~TriangleSetup()
+{
+	for (uint8_t e = 0; e < EDGE_NUM; e++) {
+		delete mEdgeXs[e];
+		delete mEdgeYs[e];
+		delete mEdgeConstants[e];
+	}
+}
+
+template<typename FORMAT>
+void TriangleSetup<FORMAT>::Setup(const List* fixedVertices, const List* indices, const List* materialIDs, const ScissorRect& scissor)
+{
+	const static FP halfOne = FP(0.5f);
+	const FP scissorMinX = FP(static_cast<float>(scissor.leftX));
+	const FP scissorMaxX = FP(static_cast<float>(scissor.rightX));
+	const FP scissorMinY = FP(static_cast<float>(scissor.topY));
+	const FP scissorMaxY = FP(static_cast<float>(scissor.bottomY));
+	// smallest edge value. edge values are multiples of it
+	DF edgeUnit;
+	edgeUnit.raw = 1;
+
+	for (uint8_t e = 0; e < EDGE_NUM; e++) {
+		mEdgeXs[e]->Reset(sizeof(DF));
+		mEdgeYs[e]->Reset(sizeof(DF));
+		mEdgeConstants[e]->Reset(sizeof(DF));
+	}
+	Reset();
+
+	uint64_t indexNum = indices->GetSize();
+	for (uint64_t indexIdx = 0; indexIdx + 2 < indexNum; indexIdx += 3) {
+		uint32_t vertexIndices[3] = {
+			indices->At<uint32_t>(indexIdx),
+			indices->At<uint32_t>(indexIdx + 1),
+			indices->At<uint32_t>(indexIdx + 2) };
+		const FixedVertex& v0 = fixedVertices->At<FixedVertex>(vertexIndices[0]);
+		const FixedVertex& v1 = fixedVertices->At<FixedVertex>(vertexIndices[1]);
+		const FixedVertex& v2 = fixedVertices->At<FixedVertex>(vertexIndices[2]);
+		const FixedVec4 v0Pos = ConvertPos(v0.pos);
+		const FixedVec4 v1Pos = ConvertPos(v1.pos);
+		const FixedVec4 v2Pos = ConvertPos(v2.pos);
+
+		// bbox limited to scissor
+		FP minX = std::max(std::min(v0Pos.x, std::min(v1Pos.x, v2Pos.x)), scissorMinX);
+		FP maxX = std::min(std::max(v0Pos.x, std::max(v1Pos.x, v2Pos.x)), scissorMaxX);
+		FP minY = std::max(std::min(v0Pos.y, std::min(v1Pos.y, v2Pos.y)), scissorMinY);
+		FP maxY = std::min(std::max(v0Pos.y, std::max(v1Pos.y, v2Pos.y)), scissorMaxY);
+
+		// pixels which centers are in bbox
+		int32_t minPixelX = (minX - halfOne).Ceil();
+		int32_t maxPixelX = (maxX - halfOne).Floor();
+		int32_t minPixelY = (minY - halfOne).Ceil();
+		int32_t maxPixelY = (maxY - halfOne).Floor();
+		if (minPixelX > maxPixelX || minPixelY > maxPixelY) {
+			continue;
+		}
+
+		// 2 * triangle size
+		//		because of precision of fixed point,
+		//		difference positions of vertices before conversion of fixed point can be same after it.
+		DF triSizeMul2 = EdgeFunction(v0Pos, v1Pos, v2Pos);
+		if (triSizeMul2 == DF::ZERO) {
+			continue;
+		}
+
+		// edge function of edge (pre, next) is (p - pre).x * (next - pre).y - (p - pre).y * (next - pre).x
+		const FixedVec4* edgePos[EDGE_NUM][2] = { { &v0Pos, &v1Pos }, { &v1Pos, &v2Pos }, { &v2Pos, &v0Pos } };
+		for (uint8_t e = 0; e < EDGE_NUM; e++) {
+			const FixedVec4& prePos = *edgePos[e][0];
+			const FixedVec4& nextPos = *edgePos[e][1];
+
+			DF edgeX = (nextPos.y - prePos.y).ToDoubleFixedPoint();
+			DF edgeY = (prePos.x - nextPos.x).ToDoubleFixedPoint();
+			DF edgeConstant = DF::ZERO - edgeX * prePos.x.ToDoubleFixedPoint() - edgeY * prePos.y.ToDoubleFixedPoint();
+
+			// pixel on left, top edge is selected. edge value <= 0 is edge value - unit < 0
+			if (IsLeftLine(prePos, nextPos) || IsTopLine(prePos, nextPos)) {
+				edgeConstant = edgeConstant - edgeUnit;
+			}
+
+			mEdgeXs[e]->Add<DF>(edgeX);
+			mEdgeYs[e]->Add<DF>(edgeY);
+			mEdgeConstants[e]->Add<DF>(edgeConstant);
+		}
+
+		mMinXs->Add<int32_t>(minPixelX);
+		mMinYs->Add<int32_t>(minPixelY);
+		mMaxXs->Add<int32_t>(maxPixelX);
+		mMaxYs->Add<int32_t>(maxPixelY);
+		mInvTriSizeMul2s->Add<double>(1.0 / triSizeMul2.ToDouble());
+		mMaterialIDs->Add<uint32_t>(materialIDs != nullptr ? materialIDs->At<uint32_t>(indexIdx / 3) : 0);
+
+		mVertexWs[0]->Add<float>(v0.pos.w.ToFloat());
+		mVertexWs[1]->Add<float>(v1.pos.w.ToFloat());
+		mVertexWs[2]->Add<float>(v2.pos.w.ToFloat());
+		for (uint8_t v = 0; v < 3; v++) {
+			mVertexIndices[v]->Add<uint32_t>(vertexIndices[v]);
+		}
+	}
+}
+
+template<typename FORMAT>
+inline bool TriangleSetup<FORMAT>::IsLeftLine(const FixedVec4& prePos, const FixedVec4& nextPos) const
+{
+	return (nextPos - prePos).y < 0;
+}
+
+template<typename FORMAT>
+inline bool TriangleSetup<FORMAT>::IsTopLine(const FixedVec4& prePos, const FixedVec4& nextPos) const
+{
+	return ((nextPos - prePos).y == 0) && ((nextPos - prePos).x > 0);
+}
+
+template class TriangleSetup<WideFixedPointFormat>;
+template class TriangleSetup<NarrowFixedPointFormat>;
\ No newline at end of file
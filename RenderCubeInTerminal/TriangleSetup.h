@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+#include "Primitive.h"
+#include "List.hpp"
+
+/// <summary>
+/// Format independent part of TriangleSetup : bbox, vertices and material of triangles.
+/// SWRasterizer sets up triangles of a draw once, then tiles are binned and rasterized through it.
+/// </summary>
+class TriangleSetupBase {
+protected:
+	static constexpr uint64_t RESERVED_TRIANGLE_NUM = 1024;
+
+public:
+	TriangleSetupBase();
+	virtual ~TriangleSetupBase();
+
+	// setup triangles which have pixel centers in scissor and non zero size.
+	// materialIDs can be null (see IRasterizable)
+	virtual void Setup(const List* fixedVertices, const List* indices, const List* materialIDs, const ScissorRect& scissor) = 0;
+
+	inline uint32_t GetTriangleNum() const {
+		return static_cast<uint32_t>(mInvTriSizeMul2s->GetSize());
+	}
+
+	// pixels [minX, maxX] x [minY, maxY] in scissor of setup
+	inline int32_t GetMinX(uint32_t triangle) const {
+		return mMinXs->At<int32_t>(triangle);
+	}
+	inline int32_t GetMinY(uint32_t triangle) const {
+		return mMinYs->At<int32_t>(triangle);
+	}
+	inline int32_t GetMaxX(uint32_t triangle) const {
+		return mMaxXs->At<int32_t>(triangle);
+	}
+	inline int32_t GetMaxY(uint32_t triangle) const {
+		return mMaxYs->At<int32_t>(triangle);
+	}
+	// bbox cut by scissor of a tile. false when no pixel of bbox is in scissor
+	inline bool GetBBoxInScissor(uint32_t triangle, const ScissorRect& scissor, int32_t* pMinX, int32_t* pMinY, int32_t* pMaxX, int32_t* pMaxY) const {
+		*pMinX = std::max(GetMinX(triangle), scissor.leftX);
+		*pMinY = std::max(GetMinY(triangle), scissor.topY);
+		*pMaxX = std::min(GetMaxX(triangle), scissor.rightX - 1);
+		*pMaxY = std::min(GetMaxY(triangle), scissor.bottomY - 1);
+
+		return *pMinX <= *pMaxX && *pMinY <= *pMaxY;
+	}
+
+	// barycentric coordinate is edge value multiplied by it
+	inline double GetInvTriSizeMul2(uint32_t triangle) const {
+		return mInvTriSizeMul2s->At<double>(triangle);
+	}
+
+	// vertex 0, 1, 2 of triangle
+	inline uint32_t GetVertexIndex(uint8_t vertex, uint32_t triangle) const {
+		return mVertexIndices[vertex]->At<uint32_t>(triangle);
+	}
+	inline float GetVertexW(uint8_t vertex, uint32_t triangle) const {
+		return mVertexWs[vertex]->At<float>(triangle);
+	}
+
+	inline uint32_t GetMaterialID(uint32_t triangle) const {
+		return mMaterialIDs->At<uint32_t>(triangle);
+	}
+
+protected:
+	void Reset();
+
+protected:
+	List* mMinXs = nullptr;
+	List* mMinYs = nullptr;
+	List* mMaxXs = nullptr;
+	List* mMaxYs = nullptr;
+	List* mInvTriSizeMul2s = nullptr;
+	List* mVertexIndices[3] = { nullptr, };
+	List* mVertexWs[3] = { nullptr, };
+	List* mMaterialIDs = nullptr;
+};
+
+/// <summary>
+/// Setup of triangles for fixed point rasterizer, in SoA.
+/// Setup pass writes every surviving triangle once and traversals only read it,
+/// so any number of traversals can consume a buffer without shared mutable state.
+/// </summary>
+template<typename FORMAT>
+class TriangleSetup final : public TriangleSetupBase {
+public:
+	typedef typename FORMAT::FP FP;
+	typedef typename FORMAT::DF DF;
+	typedef typename FORMAT::FixedVec4 FixedVec4;
+
+	// edge 01, 12, 20
+	static constexpr uint8_t EDGE_NUM = 3;
+
+public:
+	TriangleSetup();
+	virtual ~TriangleSetup() override;
+
+	virtual void Setup(const List* fixedVertices, const List* indices, const List* materialIDs, const ScissorRect& scissor) override;
+
+	// edge value of pixel center (x, y) is edgeX * x + edgeY * y + edgeConstant.
+	// top-left rule is folded into edgeConstant,
+	// so pixel is in triangle when edge values of all edges are less than 0
+	inline const DF& GetEdgeX(uint8_t edge, uint32_t triangle) const {
+		return mEdgeXs[edge]->At<DF>(triangle);
+	}
+	inline const DF& GetEdgeY(uint8_t edge, uint32_t triangle) const {
+		return mEdgeYs[edge]->At<DF>(triangle);
+	}
+	inline const DF& GetEdgeConstant(uint8_t edge, uint32_t triangle) const {
+		return mEdgeConstants[edge]->At<DF>(triangle);
+	}
+	inline DF EvaluateEdge(uint8_t edge, uint32_t triangle, FP x, FP y) const {
+		return GetEdgeX(edge, triangle) * x.ToDoubleFixedPoint()
+			+ GetEdgeY(edge, triangle) * y.ToDoubleFixedPoint()
+			+ GetEdgeConstant(edge, triangle);
+	}
+
+private:
+	// x, y of vertex in FORMAT. z, w are not used
+	static inline FixedVec4 ConvertPos(const ::FixedVec4& pos)
+	{
+		return FixedVec4(pos.x.Convert<FP::INT_BITS_LEN, FP::FRAC_BITS_LEN>(),
+			pos.y.Convert<FP::INT_BITS_LEN, FP::FRAC_BITS_LEN>(),
+			FP::ZERO,
+			FP::ZERO);
+	}
+
+	inline DF EdgeFunction(const FixedVec4& pixelPos, const FixedVec4& v0Pos, const FixedVec4& v1Pos) const
+	{
+		FixedVec4 pMinusV0 = pixelPos - v0Pos;
+		FixedVec4 v1MinusV0 = v1Pos - v0Pos;
+
+		DF v0PX = pMinusV0.x.ToDoubleFixedPoint();
+		DF v0V1Y = v1MinusV0.y.ToDoubleFixedPoint();
+		DF v0PY = pMinusV0.y.ToDoubleFixedPoint();
+		DF v0V1X = v1MinusV0.x.ToDoubleFixedPoint();
+
+		return v0PX * v0V1Y - v0PY * v0V1X;
+	}
+
+	inline bool IsLeftLine(const FixedVec4& prePos, const FixedVec4& nextPos) const;
+	inline bool IsTopLine(const FixedVec4& prePos, const FixedVec4& nextPos) const;
+
+private:
+	List* mEdgeXs[EDGE_NUM] = { nullptr, };
+	List* mEdgeYs[EDGE_NUM] = { nullptr, };
+	List* mEdgeConstants[EDGE_NUM] = { nullptr, };
+};
\ No newline at end of file
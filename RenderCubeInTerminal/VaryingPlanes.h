@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Primitive.h"
+
+/// <summary>
+/// Plane equations of varying / w over viewport x, y of a triangle.
+/// varying / w is linear in viewport space, so set up once per triangle,
+/// a pixel gets perspective correct varying by evaluating plane and multiplying w, without barycentric division.
+/// </summary>
+struct VaryingPlanes {
+	uint32_t varyingNum = 0;
+
+	// planes pass vertex 0
+	float originX = 0.0f;
+	float originY = 0.0f;
+	float origins[MAX_VARYING_NUM];
+	float dxs[MAX_VARYING_NUM];
+	float dys[MAX_VARYING_NUM];
+
+	// positions are in viewport space and w of them is w of clip space
+	inline void Setup(uint32_t num,
+		const Vec4& v0Pos, const float* v0Varyings,
+		const Vec4& v1Pos, const float* v1Varyings,
+		const Vec4& v2Pos, const float* v2Varyings)
+	{
+		varyingNum = num;
+		if (varyingNum == 0) {
+			return;
+		}
+
+		float dx10 = v1Pos.x - v0Pos.x;
+		float dy10 = v1Pos.y - v0Pos.y;
+		float dx20 = v2Pos.x - v0Pos.x;
+		float dy20 = v2Pos.y - v0Pos.y;
+		float invTriSizeMul2 = 1.0f / (dx10 * dy20 - dx20 * dy10);
+		float invW0 = 1.0f / v0Pos.w;
+		float invW1 = 1.0f / v1Pos.w;
+		float invW2 = 1.0f / v2Pos.w;
+
+		originX = v0Pos.x;
+		originY = v0Pos.y;
+		for (uint32_t i = 0; i < varyingNum; i++) {
+			float a0 = v0Varyings[i] * invW0;
+			float da10 = v1Varyings[i] * invW1 - a0;
+			float da20 = v2Varyings[i] * invW2 - a0;
+
+			origins[i] = a0;
+			dxs[i] = (da10 * dy20 - da20 * dy10) * invTriSizeMul2;
+			dys[i] = (da20 * dx10 - da10 * dx20) * invTriSizeMul2;
+		}
+	}
+
+	// w is interpolated w of clip space at (x, y)
+	inline void Interpolate(float* varyings, float x, float y, float w) const
+	{
+		float dx = x - originX;
+		float dy = y - originY;
+		for (uint32_t i = 0; i < varyingNum; i++) {
+			varyings[i] = (origins[i] + dxs[i] * dx + dys[i] * dy) * w;
+		}
+	}
+};
\ No newline at end of file
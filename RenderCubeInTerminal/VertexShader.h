@@ -0,0 +1,20 @@
+#pragma once
+#include "Primitive.h"
+
+// values which are same for all vertices of a draw
+struct VertexUniforms {
+	// object space to clip space
+	Mat4x4 modelViewProjection = Mat4x4::IDENTITY;
+};
+
+/// <summary>
+/// Vertex shader transforms vertices of a draw to clip space.
+/// Vertices are given as an array, so a shader works on several vertices at once
+/// and per draw work is done once outside of it.
+/// </summary>
+class VertexShader {
+public:
+	// outVertices has vertices.num elements. first varyingNum varyings of them are written
+	virtual void Execute(const VertexUniforms& uniforms, const ArrayView<Vertex>& vertices, uint32_t varyingNum, Vertex* outVertices) = 0;
+	virtual ~VertexShader() {}
+};